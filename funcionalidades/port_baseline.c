@@ -0,0 +1,47 @@
+#include "port_baseline.h"
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include "state_dir.h"
+
+// ports-<ip>.bitmap: los 8192 bytes del bitmap, sin cabecera
+static int baseline_file(struct in_addr addr, char *out, size_t len) {
+    char ip[INET_ADDRSTRLEN], name[64];
+    inet_ntop(AF_INET, &addr, ip, sizeof(ip));
+    snprintf(name, sizeof(name), "ports-%s.bitmap", ip);
+    return state_path(out, len, name);
+}
+
+int baseline_load(struct in_addr addr, uint8_t bits[BITMAP_BYTES]) {
+    char path[600];
+    memset(bits, 0, BITMAP_BYTES);
+    if (baseline_file(addr, path, sizeof(path)) != 0) return 0;
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return errno == ENOENT ? 0 : -1;
+    ssize_t n = read(fd, bits, BITMAP_BYTES);
+    close(fd);
+    if (n != BITMAP_BYTES) {
+        memset(bits, 0, BITMAP_BYTES);
+        return -1;
+    }
+    return 1;
+}
+
+int baseline_save(struct in_addr addr, const uint8_t bits[BITMAP_BYTES]) {
+    char path[600], tmp[620];
+    if (baseline_file(addr, path, sizeof(path)) != 0) return -1;
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) return -1;
+    ssize_t n = write(fd, bits, BITMAP_BYTES);
+    if (close(fd) != 0 || n != BITMAP_BYTES || rename(tmp, path) != 0) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
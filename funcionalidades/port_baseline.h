@@ -0,0 +1,25 @@
+#ifndef PORT_BASELINE_H
+#define PORT_BASELINE_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+
+#define BITMAP_BYTES (65536 / 8)     // Un bit por puerto: 8 KB por objetivo
+
+static inline int bitmap_test(const uint8_t *bits, int port) {
+    return bits[port >> 3] & (1 << (port & 7));
+}
+
+// Seguro entre hilos: varios trabajadores marcan puertos del mismo objetivo
+static inline void bitmap_set_atomic(uint8_t *bits, int port) {
+    __atomic_fetch_or(&bits[port >> 3], (uint8_t)(1 << (port & 7)), __ATOMIC_RELAXED);
+}
+
+// Lee la línea base guardada de un objetivo. Devuelve 1 si existía, 0 si
+// no (bits queda a cero) y -1 si el fichero está dañado.
+int baseline_load(struct in_addr addr, uint8_t bits[BITMAP_BYTES]);
+
+// Guarda la línea base de forma atómica (fichero temporal + rename)
+int baseline_save(struct in_addr addr, const uint8_t bits[BITMAP_BYTES]);
+
+#endif
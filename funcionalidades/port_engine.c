@@ -0,0 +1,556 @@
+#define _GNU_SOURCE
+#include "port_engine.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+
+#define FD_RESERVE 64        // Descriptores que dejamos libres para el resto del programa
+#define EPOLL_BATCH 1024
+#define RTT_LOCKS 64         // Cerrojos repartidos entre las entradas de la tabla RTT
+
+typedef enum {
+    PHASE_CONNECT,           // Esperando a que termine connect()
+    PHASE_BANNER,            // Conectado, esperando los primeros bytes
+} probe_phase_t;
+
+typedef struct {
+    int fd;                  // -1 si la ranura está libre
+    probe_phase_t phase;
+    int port;
+    struct in_addr addr;
+    long start_us;           // Momento del connect(), para medir el RTT
+    long deadline_us;
+    int heap_pos;
+} probe_slot_t;
+
+typedef struct {
+    probe_slot_t *slots;
+    int *free_list;
+    int free_count;
+    int *heap;               // Montículo mínimo de ranuras ordenado por plazo
+    int heap_len;
+} engine_state_t;
+
+// Estimador de RTT por host al estilo TCP (RFC 6298), compartido por todos
+// los hilos de un escaneo. Tabla de direccionamiento abierto de tamaño fijo;
+// la dirección 0 marca una entrada libre.
+typedef struct {
+    uint32_t addr;
+    unsigned samples;
+    long srtt_us;
+    long rttvar_us;
+} rtt_entry_t;
+
+typedef struct {
+    rtt_entry_t *entries;
+    size_t cap;              // Potencia de dos
+    pthread_mutex_t locks[RTT_LOCKS];
+    long min_us;
+    long max_us;
+} rtt_table_t;
+
+static long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000L;
+}
+
+// Sube el límite de descriptores al máximo permitido y devuelve el resultado
+static int raise_fd_limit(void) {
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) != 0) return 1024;
+    if (rl.rlim_cur < rl.rlim_max) {
+        rl.rlim_cur = rl.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &rl);
+        getrlimit(RLIMIT_NOFILE, &rl);
+    }
+    return rl.rlim_cur > 1 << 20 ? 1 << 20 : (int)rl.rlim_cur;
+}
+
+// --- Tabla RTT ---
+static int rtt_init(rtt_table_t *t, const engine_config_t *cfg) {
+    size_t want = cfg->hosts_hint > 0 ? (size_t)cfg->hosts_hint * 2 : 64;
+    t->cap = 64;
+    while (t->cap < want) t->cap <<= 1;
+    t->entries = calloc(t->cap, sizeof(rtt_entry_t));
+    if (!t->entries) return -1;
+    for (int i = 0; i < RTT_LOCKS; i++) pthread_mutex_init(&t->locks[i], NULL);
+    t->max_us = (cfg->timeout_ms > 0 ? cfg->timeout_ms : ENGINE_DEFAULT_TIMEOUT_MS) * 1000L;
+    t->min_us = cfg->min_timeout_ms * 1000L;
+    if (t->min_us > t->max_us) t->min_us = t->max_us;
+    return 0;
+}
+
+static void rtt_destroy(rtt_table_t *t) {
+    for (int i = 0; i < RTT_LOCKS; i++) pthread_mutex_destroy(&t->locks[i]);
+    free(t->entries);
+}
+
+// Entrada del host, creándola si no existe. NULL si la tabla está llena.
+static rtt_entry_t *rtt_find(rtt_table_t *t, uint32_t addr) {
+    if (!addr) return NULL;
+    size_t mask = t->cap - 1;
+    size_t i = (addr * 2654435761u) & mask;
+    for (size_t probes = 0; probes < t->cap; probes++, i = (i + 1) & mask) {
+        uint32_t cur = __atomic_load_n(&t->entries[i].addr, __ATOMIC_ACQUIRE);
+        if (cur == addr) return &t->entries[i];
+        if (cur == 0) {
+            uint32_t expected = 0;
+            if (__atomic_compare_exchange_n(&t->entries[i].addr, &expected, addr, 0,
+                                            __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)
+                || expected == addr)
+                return &t->entries[i];
+        }
+    }
+    return NULL;
+}
+
+static pthread_mutex_t *rtt_lock(rtt_table_t *t, const rtt_entry_t *e) {
+    return &t->locks[(size_t)(e - t->entries) % RTT_LOCKS];
+}
+
+// Plazo de la próxima sonda al host: SRTT + 4·RTTVAR acotado a [min, max].
+// Sin muestras todavía se usa el máximo.
+static long rtt_timeout(rtt_table_t *t, struct in_addr addr) {
+    if (t->min_us <= 0) return t->max_us;              // Plazo fijo
+    rtt_entry_t *e = rtt_find(t, addr.s_addr);
+    if (!e) return t->max_us;
+    pthread_mutex_t *m = rtt_lock(t, e);
+    pthread_mutex_lock(m);
+    long rto = e->samples ? e->srtt_us + 4 * e->rttvar_us : t->max_us;
+    pthread_mutex_unlock(m);
+    if (rto < t->min_us) rto = t->min_us;
+    if (rto > t->max_us) rto = t->max_us;
+    return rto;
+}
+
+static void rtt_sample(rtt_table_t *t, struct in_addr addr, long rtt) {
+    rtt_entry_t *e = rtt_find(t, addr.s_addr);
+    if (!e) return;
+    pthread_mutex_t *m = rtt_lock(t, e);
+    pthread_mutex_lock(m);
+    if (e->samples++ == 0) {
+        e->srtt_us = rtt;
+        e->rttvar_us = rtt / 2;
+    } else {
+        long err = rtt > e->srtt_us ? rtt - e->srtt_us : e->srtt_us - rtt;
+        e->rttvar_us += (err - e->rttvar_us) / 4;
+        e->srtt_us += (rtt - e->srtt_us) / 8;
+    }
+    pthread_mutex_unlock(m);
+}
+
+// Resume los plazos finales de todos los hosts medidos en stats
+static void rtt_summary(rtt_table_t *t, engine_stats_t *stats) {
+    stats->hosts_measured = 0;
+    stats->rto_min_us = stats->rto_max_us = 0;
+    for (size_t i = 0; i < t->cap; i++) {
+        rtt_entry_t *e = &t->entries[i];
+        if (!e->addr || !e->samples) continue;
+        long rto = rtt_timeout(t, (struct in_addr){.s_addr = e->addr});
+        if (!stats->hosts_measured || rto < stats->rto_min_us) stats->rto_min_us = rto;
+        if (!stats->hosts_measured || rto > stats->rto_max_us) stats->rto_max_us = rto;
+        stats->hosts_measured++;
+    }
+}
+
+// --- Estadísticas de espera ---
+static void record_wait(engine_stats_t *stats, long waited_us) {
+    if (waited_us < 0) waited_us = 0;
+    int b = 0;
+    while (b < ENGINE_WAIT_BUCKETS - 1 && waited_us >= (2L << b)) b++;
+    stats->wait_hist[b]++;
+    stats->wait_total_us += waited_us;
+    if (waited_us > stats->wait_max_us) stats->wait_max_us = waited_us;
+}
+
+long engine_wait_percentile(const engine_stats_t *stats, double q) {
+    unsigned long total = 0, acc = 0;
+    for (int b = 0; b < ENGINE_WAIT_BUCKETS; b++) total += stats->wait_hist[b];
+    if (!total) return 0;
+    unsigned long rank = (unsigned long)(q * total);
+    if (rank >= total) rank = total - 1;
+    for (int b = 0; b < ENGINE_WAIT_BUCKETS; b++) {
+        acc += stats->wait_hist[b];
+        if (acc > rank) {
+            long upper = 2L << b;                     // Cota superior del cubo
+            return upper < stats->wait_max_us ? upper : stats->wait_max_us;
+        }
+    }
+    return stats->wait_max_us;
+}
+
+static void merge_stats(engine_stats_t *sum, const engine_stats_t *s) {
+    sum->sent += s->sent;
+    sum->open += s->open;
+    sum->closed += s->closed;
+    sum->filtered += s->filtered;
+    sum->timeouts += s->timeouts;
+    sum->wait_total_us += s->wait_total_us;
+    if (s->wait_max_us > sum->wait_max_us) sum->wait_max_us = s->wait_max_us;
+    for (int b = 0; b < ENGINE_WAIT_BUCKETS; b++) sum->wait_hist[b] += s->wait_hist[b];
+}
+
+// --- Montículo de plazos ---
+static void heap_swap(engine_state_t *st, int a, int b) {
+    int t = st->heap[a];
+    st->heap[a] = st->heap[b];
+    st->heap[b] = t;
+    st->slots[st->heap[a]].heap_pos = a;
+    st->slots[st->heap[b]].heap_pos = b;
+}
+
+static void heap_up(engine_state_t *st, int i) {
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (st->slots[st->heap[p]].deadline_us <= st->slots[st->heap[i]].deadline_us) break;
+        heap_swap(st, i, p);
+        i = p;
+    }
+}
+
+static void heap_down(engine_state_t *st, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < st->heap_len && st->slots[st->heap[l]].deadline_us < st->slots[st->heap[m]].deadline_us) m = l;
+        if (r < st->heap_len && st->slots[st->heap[r]].deadline_us < st->slots[st->heap[m]].deadline_us) m = r;
+        if (m == i) break;
+        heap_swap(st, i, m);
+        i = m;
+    }
+}
+
+static void heap_push(engine_state_t *st, int slot) {
+    st->heap[st->heap_len] = slot;
+    st->slots[slot].heap_pos = st->heap_len++;
+    heap_up(st, st->heap_len - 1);
+}
+
+static void heap_remove(engine_state_t *st, int slot) {
+    int i = st->slots[slot].heap_pos;
+    st->heap_len--;
+    if (i != st->heap_len) {
+        heap_swap(st, i, st->heap_len);
+        heap_down(st, i);
+        heap_up(st, i);
+    }
+}
+
+// Cierra con RST (SO_LINGER 0) para no dejar TIME_WAIT ni agotar puertos efímeros
+static void hard_close(int fd) {
+    struct linger lg = {1, 0};
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+static void release_slot(engine_state_t *st, int epfd, int slot) {
+    probe_slot_t *p = &st->slots[slot];
+    heap_remove(st, slot);
+    epoll_ctl(epfd, EPOLL_CTL_DEL, p->fd, NULL);
+    hard_close(p->fd);
+    p->fd = -1;
+    st->free_list[st->free_count++] = slot;
+}
+
+// En loopback el kernel puede elegir como puerto origen el mismo puerto
+// destino y conectar el socket consigo mismo: no es un servicio abierto.
+static int is_self_connect(int fd, const struct in_addr *addr, int port) {
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    if (getsockname(fd, (struct sockaddr *)&local, &len) != 0) return 0;
+    return ntohs(local.sin_port) == port && local.sin_addr.s_addr == addr->s_addr;
+}
+
+static void report(engine_stats_t *stats, engine_result_fn on_result, void *ctx,
+                   const struct in_addr *addr, int port, port_state_t state,
+                   const char *banner, int banner_len) {
+    if (state == PORT_OPEN) stats->open++;
+    else if (state == PORT_CLOSED) stats->closed++;
+    else stats->filtered++;
+    if (!on_result) return;
+    engine_result_t res = {
+        .addr = *addr,
+        .port = port,
+        .state = state,
+        .banner = banner,
+        .banner_len = banner_len,
+    };
+    on_result(&res, ctx);
+}
+
+static port_state_t state_from_errno(int err) {
+    return err == 0 ? PORT_OPEN : err == ECONNREFUSED ? PORT_CLOSED : PORT_FILTERED;
+}
+
+// Lanza una sonda. Devuelve 1 si quedó en vuelo o resuelta, 0 si hay que
+// reintentarla más tarde por falta de recursos (descriptores o puertos).
+static int launch(engine_state_t *st, int epfd, rtt_table_t *rtt,
+                  struct in_addr addr, int port, engine_stats_t *stats,
+                  engine_result_fn on_result, void *ctx) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+
+    struct sockaddr_in target;
+    memset(&target, 0, sizeof(target));
+    target.sin_family = AF_INET;
+    target.sin_port = htons(port);
+    target.sin_addr = addr;
+
+    // Un connect() que termina al instante (loopback) se resuelve igual que
+    // uno en curso: EPOLLOUT salta enseguida y pasa por el mismo camino.
+    long start = now_us();
+    int rc = connect(fd, (struct sockaddr *)&target, sizeof(target));
+    if (rc != 0 && errno != EINPROGRESS) {
+        int err = errno;
+        close(fd);
+        if (err == EAGAIN || err == EADDRNOTAVAIL) return 0;
+        stats->sent++;
+        record_wait(stats, now_us() - start);
+        report(stats, on_result, ctx, &addr, port, state_from_errno(err), NULL, 0);
+        return 1;
+    }
+
+    int slot = st->free_list[--st->free_count];
+    probe_slot_t *p = &st->slots[slot];
+    p->fd = fd;
+    p->phase = PHASE_CONNECT;
+    p->port = port;
+    p->addr = addr;
+    p->start_us = start;
+    p->deadline_us = start + rtt_timeout(rtt, addr);
+
+    struct epoll_event ev = {.events = EPOLLOUT, .data.u32 = slot};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+        close(fd);
+        p->fd = -1;
+        st->free_list[st->free_count++] = slot;
+        return 0;
+    }
+    heap_push(st, slot);
+    stats->sent++;
+    return 1;
+}
+
+static int engine_run_shared(const engine_config_t *cfg, rtt_table_t *rtt, engine_next_fn next, void *src,
+                             engine_result_fn on_result, void *ctx, engine_stats_t *stats) {
+    engine_config_t conf = *cfg;
+    memset(stats, 0, sizeof(*stats));
+
+    int fd_limit = raise_fd_limit() - FD_RESERVE;
+    if (conf.max_inflight <= 0) conf.max_inflight = ENGINE_DEFAULT_INFLIGHT;
+    if (conf.max_inflight > fd_limit) conf.max_inflight = fd_limit > 1 ? fd_limit : 1;
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("epoll_create1");
+        return -1;
+    }
+
+    engine_state_t st;
+    st.slots = calloc(conf.max_inflight, sizeof(probe_slot_t));
+    st.free_list = malloc(conf.max_inflight * sizeof(int));
+    st.heap = malloc(conf.max_inflight * sizeof(int));
+    st.heap_len = 0;
+    st.free_count = conf.max_inflight;
+    if (!st.slots || !st.free_list || !st.heap) {
+        free(st.slots);
+        free(st.free_list);
+        free(st.heap);
+        close(epfd);
+        return -1;
+    }
+    for (int i = 0; i < conf.max_inflight; i++) {
+        st.slots[i].fd = -1;
+        st.free_list[i] = conf.max_inflight - 1 - i;
+    }
+
+    struct epoll_event events[EPOLL_BATCH];
+    struct in_addr pending_addr;
+    int pending_port = 0, have_pending = 0, exhausted = 0;
+
+    while (!exhausted || have_pending || st.heap_len > 0) {
+        // Rellenar la ventana de conexiones en vuelo
+        while (st.free_count > 0) {
+            if (!have_pending) {
+                if (exhausted || !next(src, &pending_addr, &pending_port)) {
+                    exhausted = 1;
+                    break;
+                }
+                have_pending = 1;
+            }
+            if (!launch(&st, epfd, rtt, pending_addr, pending_port, stats, on_result, ctx)) {
+                // Sin recursos: esperar a que termine alguna sonda. Si no hay
+                // ninguna en vuelo no hay nada que esperar y se da por filtrado.
+                if (st.heap_len == 0) {
+                    stats->sent++;
+                    report(stats, on_result, ctx, &pending_addr, pending_port, PORT_FILTERED, NULL, 0);
+                    have_pending = 0;
+                }
+                break;
+            }
+            have_pending = 0;
+        }
+        if (st.heap_len == 0) continue;
+
+        long wait = st.slots[st.heap[0]].deadline_us - now_us();
+        int n = epoll_wait(epfd, events, EPOLL_BATCH, wait > 0 ? (int)((wait + 999) / 1000) : 0);
+        if (n < 0 && errno != EINTR) {
+            perror("epoll_wait");
+            break;
+        }
+
+        for (int i = 0; i < n; i++) {
+            int slot = events[i].data.u32;
+            probe_slot_t *p = &st.slots[slot];
+            struct in_addr addr = p->addr;
+            int port = p->port;
+
+            if (p->phase == PHASE_BANNER) {
+                // Lo que haya llegado es el banner; EOF o error, banner vacío
+                char banner[ENGINE_BANNER_MAX];
+                ssize_t got = recv(p->fd, banner, sizeof(banner), MSG_DONTWAIT);
+                release_slot(&st, epfd, slot);
+                report(stats, on_result, ctx, &addr, port, PORT_OPEN, banner, got > 0 ? (int)got : 0);
+                continue;
+            }
+
+            int err = 0;
+            socklen_t len = sizeof(err);
+            getsockopt(p->fd, SOL_SOCKET, SO_ERROR, &err, &len);
+            if (err == 0 && is_self_connect(p->fd, &p->addr, p->port)) err = ECONNREFUSED;
+
+            // Tanto el SYN-ACK como el RST son una medida válida del RTT
+            long now = now_us();
+            record_wait(stats, now - p->start_us);
+            if (err == 0 || err == ECONNREFUSED) rtt_sample(rtt, addr, now - p->start_us);
+
+            if (err == 0 && conf.banner_ms > 0) {
+                // Conectado: misma ranura, ahora esperando datos con su propio plazo
+                struct epoll_event ev = {.events = EPOLLIN | EPOLLRDHUP, .data.u32 = slot};
+                if (epoll_ctl(epfd, EPOLL_CTL_MOD, p->fd, &ev) == 0) {
+                    p->phase = PHASE_BANNER;
+                    heap_remove(&st, slot);
+                    p->deadline_us = now + conf.banner_ms * 1000L;
+                    heap_push(&st, slot);
+                    continue;
+                }
+            }
+
+            release_slot(&st, epfd, slot);
+            report(stats, on_result, ctx, &addr, port, state_from_errno(err), NULL, 0);
+        }
+
+        // Expirar sondas sin respuesta. Si ya conectó, el puerto está abierto
+        // aunque el servicio no haya enviado banner. Con plazos ajustados al
+        // RTT, una respuesta puede estar ya en la cola de epoll sin procesar:
+        // solo se expira cuando la cola quedó vacía en esta vuelta.
+        if (n == EPOLL_BATCH) continue;
+        long now = now_us();
+        while (st.heap_len > 0 && st.slots[st.heap[0]].deadline_us <= now) {
+            int slot = st.heap[0];
+            probe_slot_t *p = &st.slots[slot];
+            struct in_addr addr = p->addr;
+            int port = p->port;
+            port_state_t state = PORT_OPEN;
+            if (p->phase == PHASE_CONNECT) {
+                state = PORT_FILTERED;
+                stats->timeouts++;
+                record_wait(stats, now - p->start_us);
+            }
+            release_slot(&st, epfd, slot);
+            report(stats, on_result, ctx, &addr, port, state, NULL, 0);
+        }
+    }
+
+    free(st.slots);
+    free(st.free_list);
+    free(st.heap);
+    close(epfd);
+    return 0;
+}
+
+int engine_run(const engine_config_t *cfg, engine_next_fn next, void *src,
+               engine_result_fn on_result, void *ctx, engine_stats_t *stats) {
+    engine_stats_t local_stats;
+    if (!stats) stats = &local_stats;
+
+    rtt_table_t rtt;
+    if (rtt_init(&rtt, cfg) != 0) return -1;
+    int rc = engine_run_shared(cfg, &rtt, next, src, on_result, ctx, stats);
+    rtt_summary(&rtt, stats);
+    rtt_destroy(&rtt);
+    return rc;
+}
+
+typedef struct {
+    engine_config_t cfg;
+    rtt_table_t *rtt;
+    engine_next_fn next;
+    void *src;
+    engine_result_fn on_result;
+    void *ctx;
+    engine_stats_t stats;
+    int rc;
+} pool_worker_t;
+
+static void *pool_worker(void *arg) {
+    pool_worker_t *w = arg;
+    w->rc = engine_run_shared(&w->cfg, w->rtt, w->next, w->src, w->on_result, w->ctx, &w->stats);
+    return NULL;
+}
+
+int engine_run_pool(const engine_config_t *cfg, engine_next_fn next, void *src,
+                    engine_result_fn on_result, void *ctx, engine_stats_t *stats) {
+    int workers = cfg->workers;
+    if (workers <= 0) workers = (int)sysconf(_SC_NPROCESSORS_ONLN);
+    if (workers > ENGINE_MAX_WORKERS) workers = ENGINE_MAX_WORKERS;
+    if (workers <= 1) return engine_run(cfg, next, src, on_result, ctx, stats);
+
+    int total = cfg->max_inflight > 0 ? cfg->max_inflight : ENGINE_DEFAULT_INFLIGHT;
+    if (total < workers) workers = total;
+
+    // Todos los hilos alimentan y consultan la misma estimación de RTT
+    rtt_table_t rtt;
+    if (rtt_init(&rtt, cfg) != 0) return -1;
+
+    pool_worker_t w[ENGINE_MAX_WORKERS];
+    pthread_t th[ENGINE_MAX_WORKERS];
+    int started = 0;
+    for (int i = 0; i < workers; i++) {
+        w[i].cfg = *cfg;
+        w[i].cfg.max_inflight = total / workers + (i < total % workers);
+        w[i].rtt = &rtt;
+        w[i].next = next;
+        w[i].src = src;
+        w[i].on_result = on_result;
+        w[i].ctx = ctx;
+        w[i].rc = 0;
+        if (pthread_create(&th[i], NULL, pool_worker, &w[i]) != 0) break;
+        started++;
+    }
+    if (started == 0) {
+        rtt_destroy(&rtt);
+        return engine_run(cfg, next, src, on_result, ctx, stats);
+    }
+
+    int rc = 0;
+    engine_stats_t sum = {0};
+    for (int i = 0; i < started; i++) {
+        pthread_join(th[i], NULL);
+        if (w[i].rc != 0) rc = -1;
+        merge_stats(&sum, &w[i].stats);
+    }
+    rtt_summary(&rtt, &sum);
+    rtt_destroy(&rtt);
+    if (stats) *stats = sum;
+    return rc;
+}
@@ -0,0 +1,72 @@
+#ifndef PORT_ENGINE_H
+#define PORT_ENGINE_H
+
+#include <netinet/in.h>
+
+#define ENGINE_DEFAULT_INFLIGHT 4096   // Conexiones simultáneas por defecto
+#define ENGINE_DEFAULT_TIMEOUT_MS 1000 // Plazo por sonda (ms)
+#define ENGINE_MAX_WORKERS 64
+#define ENGINE_BANNER_MAX 256          // Bytes de banner que se leen como máximo
+#define ENGINE_WAIT_BUCKETS 25         // Cubos log2 del histograma de esperas (µs)
+
+typedef enum {
+    PORT_OPEN,
+    PORT_CLOSED,
+    PORT_FILTERED,
+} port_state_t;
+
+typedef struct {
+    int max_inflight;   // Máximo de connect() no bloqueantes en vuelo
+    int timeout_ms;     // Plazo máximo de cada sonda
+    int min_timeout_ms; // Plazo mínimo adaptativo por RTT (0 = plazo fijo)
+    int hosts_hint;     // Número aproximado de objetivos, para dimensionar la tabla RTT
+    int workers;        // Hilos para engine_run_pool (0 = uno por CPU)
+    int banner_ms;      // Espera de banner tras conectar (0 = no leer banners)
+    int rate_pps;       // Ritmo de envío del escaneo SYN (0 = SYN_DEFAULT_RATE)
+} engine_config_t;
+
+typedef struct {
+    unsigned long sent;
+    unsigned long open;
+    unsigned long closed;
+    unsigned long filtered;
+    unsigned long timeouts;                          // Sondas que agotaron su plazo
+    unsigned long wait_hist[ENGINE_WAIT_BUCKETS];    // Cubo b: espera < 2^(b+1) µs
+    long wait_total_us;
+    long wait_max_us;
+    unsigned long hosts_measured;                    // Hosts con al menos una muestra de RTT
+    long rto_min_us;                                 // Plazo final más corto y más largo
+    long rto_max_us;                                 // entre los hosts medidos
+} engine_stats_t;
+
+// Devuelve 1 y rellena addr/port con la siguiente sonda, o 0 si no quedan
+typedef int (*engine_next_fn)(void *src, struct in_addr *addr, int *port);
+
+typedef struct {
+    struct in_addr addr;
+    int port;
+    port_state_t state;
+    const char *banner;  // Primeros bytes enviados por el servicio (no terminado en '\0')
+    int banner_len;      // 0 si no se pidió banner o el servicio no habló a tiempo
+} engine_result_t;
+
+// Se invoca en cuanto una sonda termina (no en orden de puerto)
+typedef void (*engine_result_fn)(const engine_result_t *res, void *ctx);
+
+// Espera aproximada (µs) del cuantil q (0..1) según el histograma de stats
+long engine_wait_percentile(const engine_stats_t *stats, double q);
+
+// Ejecuta todas las sondas de la fuente manteniendo hasta max_inflight
+// conexiones en vuelo sobre un único epoll. El plazo de cada sonda se adapta
+// al RTT medido de su host (SRTT + 4·RTTVAR, RFC 6298) entre min_timeout_ms y
+// timeout_ms. Devuelve 0 o -1 si falla epoll.
+int engine_run(const engine_config_t *cfg, engine_next_fn next, void *src,
+               engine_result_fn on_result, void *ctx, engine_stats_t *stats);
+
+// Igual que engine_run pero repartiendo las sondas entre cfg->workers hilos,
+// cada uno con su propio epoll y una parte de max_inflight. La fuente y el
+// callback se llaman desde varios hilos a la vez y deben ser seguros.
+int engine_run_pool(const engine_config_t *cfg, engine_next_fn next, void *src,
+                    engine_result_fn on_result, void *ctx, engine_stats_t *stats);
+
+#endif
@@ -0,0 +1,156 @@
+#define _GNU_SOURCE
+#include "port_local.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+
+#define TCP_LISTEN_STATE 10          // TCP_LISTEN en include/net/tcp_states.h
+#define TCP_CLOSE_STATE 7            // Estado de un socket UDP ligado sin conectar
+#define DIAG_BUF_SIZE (32 * 1024)
+
+static int add_listener(listener_list_t *l, int proto, int family, int port,
+                        unsigned long inode, const void *raw_addr) {
+    if (port == 0) return 0;
+    if (l->count == l->cap) {
+        size_t cap = l->cap ? l->cap * 2 : 64;
+        local_listener_t *items = realloc(l->items, cap * sizeof(*items));
+        if (!items) return -1;
+        l->items = items;
+        l->cap = cap;
+    }
+    local_listener_t *it = &l->items[l->count++];
+    it->proto = proto;
+    it->family = family;
+    it->port = port;
+    it->inode = inode;
+    inet_ntop(family, raw_addr, it->addr, sizeof(it->addr));
+    return 0;
+}
+
+// --- NETLINK_SOCK_DIAG ---
+static int diag_dump(int nl, listener_list_t *l, int family, int proto) {
+    struct {
+        struct nlmsghdr nlh;
+        struct inet_diag_req_v2 req;
+    } msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.nlh.nlmsg_len = sizeof(msg);
+    msg.nlh.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    msg.nlh.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    msg.req.sdiag_family = family;
+    msg.req.sdiag_protocol = proto;
+    msg.req.idiag_states = proto == IPPROTO_TCP ? 1 << TCP_LISTEN_STATE : 1 << TCP_CLOSE_STATE;
+
+    struct sockaddr_nl kernel = {.nl_family = AF_NETLINK};
+    if (sendto(nl, &msg, sizeof(msg), 0, (struct sockaddr *)&kernel, sizeof(kernel)) < 0)
+        return -1;
+
+    static char buf[DIAG_BUF_SIZE] __attribute__((aligned(NLMSG_ALIGNTO)));
+    for (;;) {
+        ssize_t len = recv(nl, buf, sizeof(buf), 0);
+        if (len < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        for (struct nlmsghdr *h = (struct nlmsghdr *)buf; NLMSG_OK(h, len); h = NLMSG_NEXT(h, len)) {
+            if (h->nlmsg_type == NLMSG_DONE) return 0;
+            if (h->nlmsg_type == NLMSG_ERROR) return -1;   // p. ej. udp_diag no cargado
+            struct inet_diag_msg *d = NLMSG_DATA(h);
+            if (add_listener(l, proto, d->idiag_family, ntohs(d->id.idiag_sport),
+                             d->idiag_inode, d->id.idiag_src) != 0)
+                return -1;
+        }
+    }
+}
+
+// --- /proc/net/{tcp,udp}[6] ---
+static int hex_to_addr(const char *hex, int family, void *out) {
+    if (family == AF_INET) {
+        unsigned int a;
+        if (sscanf(hex, "%8X", &a) != 1) return -1;
+        memcpy(out, &a, 4);                 // El kernel la escribe en orden de host
+        return 0;
+    }
+    // IPv6: cuatro palabras de 32 bits, cada una en orden de host
+    for (int i = 0; i < 4; i++) {
+        unsigned int w;
+        if (sscanf(hex + i * 8, "%8X", &w) != 1) return -1;
+        memcpy((char *)out + i * 4, &w, 4);
+    }
+    return 0;
+}
+
+static int proc_dump(listener_list_t *l, int family, int proto) {
+    const char *path = proto == IPPROTO_TCP
+        ? (family == AF_INET ? "/proc/net/tcp" : "/proc/net/tcp6")
+        : (family == AF_INET ? "/proc/net/udp" : "/proc/net/udp6");
+    FILE *f = fopen(path, "r");
+    if (!f) return family == AF_INET6 ? 0 : -1;   // Sin IPv6 no es un error
+
+    int want = proto == IPPROTO_TCP ? TCP_LISTEN_STATE : TCP_CLOSE_STATE;
+    char line[512];
+    fgets(line, sizeof(line), f);                 // Cabecera
+    while (fgets(line, sizeof(line), f)) {
+        char local[64];
+        unsigned int port, state;
+        unsigned long inode;
+        if (sscanf(line, " %*d: %63[0-9A-Fa-f]:%X %*s %X %*s %*s %*s %*d %*d %lu",
+                   local, &port, &state, &inode) != 4)
+            continue;
+        if ((int)state != want) continue;
+        unsigned char raw[16];
+        if (hex_to_addr(local, family, raw) != 0) continue;
+        if (add_listener(l, proto, family, port, inode, raw) != 0) {
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int cmp_listener(const void *a, const void *b) {
+    const local_listener_t *x = a, *y = b;
+    if (x->proto != y->proto) return x->proto - y->proto;
+    if (x->port != y->port) return x->port - y->port;
+    return x->family - y->family;
+}
+
+int local_listeners(listener_list_t *out) {
+    static const int families[] = {AF_INET, AF_INET6};
+    static const int protos[] = {IPPROTO_TCP, IPPROTO_UDP};
+    memset(out, 0, sizeof(*out));
+
+    int nl = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    int used_proc = 0;
+    for (int p = 0; p < 2; p++) {
+        for (int f = 0; f < 2; f++) {
+            size_t before = out->count;
+            if (nl >= 0 && diag_dump(nl, out, families[f], protos[p]) == 0) continue;
+            // Fallo a mitad de volcado: descartar lo parcial y leer /proc
+            out->count = before;
+            used_proc = 1;
+            if (proc_dump(out, families[f], protos[p]) != 0) {
+                if (nl >= 0) close(nl);
+                listeners_free(out);
+                return -1;
+            }
+        }
+    }
+    if (nl >= 0) close(nl);
+
+    out->source = used_proc ? "/proc/net" : "sock_diag";
+    qsort(out->items, out->count, sizeof(*out->items), cmp_listener);
+    return 0;
+}
+
+void listeners_free(listener_list_t *l) {
+    free(l->items);
+    memset(l, 0, sizeof(*l));
+}
@@ -0,0 +1,30 @@
+#ifndef PORT_LOCAL_H
+#define PORT_LOCAL_H
+
+#include <stddef.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+typedef struct {
+    int proto;                       // IPPROTO_TCP o IPPROTO_UDP
+    int family;                      // AF_INET o AF_INET6
+    int port;
+    unsigned long inode;             // Inodo del socket (para buscar el proceso dueño)
+    char addr[INET6_ADDRSTRLEN];     // Dirección local de escucha
+} local_listener_t;
+
+typedef struct {
+    local_listener_t *items;
+    size_t count;
+    size_t cap;
+    const char *source;              // "sock_diag" o "/proc/net"
+} listener_list_t;
+
+// Enumera todos los sockets TCP en LISTEN y UDP ligados de la máquina sin
+// enviar ningún paquete: un volcado NETLINK_SOCK_DIAG por familia/protocolo
+// y, si el kernel no lo permite, /proc/net/{tcp,tcp6,udp,udp6}.
+// La lista sale ordenada por protocolo y puerto. Devuelve 0 o -1.
+int local_listeners(listener_list_t *out);
+void listeners_free(listener_list_t *l);
+
+#endif
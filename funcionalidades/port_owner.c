@@ -0,0 +1,289 @@
+#define _GNU_SOURCE
+#include "port_owner.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <ctype.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+// Tabla hash de claves/valores de 64 bits con sondeo lineal. La clave 0
+// marca una celda vacía (no existen ni el PID 0 ni el inodo 0).
+typedef struct {
+    uint64_t *keys;
+    uint64_t *vals;
+    size_t cap;                  // Potencia de dos
+    size_t len;
+} u64map_t;
+
+typedef struct {
+    int pid;
+    unsigned long long start_time;
+    long fd_count;               // st_size de /proc/PID/fd
+    unsigned generation;         // Última pasada en la que se vio vivo
+    char name[256];
+    unsigned long *inodes;       // Sockets que este proceso aportó al índice
+    size_t n_inodes;
+    size_t cap_inodes;
+} owner_proc_t;
+
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static u64map_t by_inode;        // inodo -> (pid << 32 | fd)
+static u64map_t by_pid;          // pid -> índice en procs
+static owner_proc_t *procs;
+static size_t n_procs, cap_procs;
+static unsigned generation;
+static int forced_since_refresh;
+
+static size_t hash64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (size_t)k;
+}
+
+static size_t map_slot(const u64map_t *m, uint64_t key) {
+    size_t i = hash64(key) & (m->cap - 1);
+    while (m->keys[i] && m->keys[i] != key) i = (i + 1) & (m->cap - 1);
+    return i;
+}
+
+static int map_get(const u64map_t *m, uint64_t key, uint64_t *val) {
+    if (!m->cap) return 0;
+    size_t i = map_slot(m, key);
+    if (!m->keys[i]) return 0;
+    *val = m->vals[i];
+    return 1;
+}
+
+static void map_put(u64map_t *m, uint64_t key, uint64_t val);
+
+static void map_grow(u64map_t *m) {
+    u64map_t old = *m;
+    m->cap = old.cap ? old.cap * 2 : 1024;
+    m->keys = calloc(m->cap, sizeof(uint64_t));
+    m->vals = malloc(m->cap * sizeof(uint64_t));
+    m->len = 0;
+    for (size_t i = 0; i < old.cap; i++)
+        if (old.keys[i]) map_put(m, old.keys[i], old.vals[i]);
+    free(old.keys);
+    free(old.vals);
+}
+
+static void map_put(u64map_t *m, uint64_t key, uint64_t val) {
+    if ((m->len + 1) * 10 >= m->cap * 7) map_grow(m);
+    size_t i = map_slot(m, key);
+    if (!m->keys[i]) {
+        m->keys[i] = key;
+        m->len++;
+    }
+    m->vals[i] = val;
+}
+
+// Borrado con desplazamiento hacia atrás: no deja lápidas en la tabla
+static void map_del(u64map_t *m, uint64_t key) {
+    if (!m->cap) return;
+    size_t i = map_slot(m, key);
+    if (!m->keys[i]) return;
+    size_t mask = m->cap - 1;
+    for (size_t j = (i + 1) & mask; m->keys[j]; j = (j + 1) & mask) {
+        size_t home = hash64(m->keys[j]) & mask;
+        // Mover j a i si su posición ideal no está en el tramo (i, j]
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            m->keys[i] = m->keys[j];
+            m->vals[i] = m->vals[j];
+            i = j;
+        }
+    }
+    m->keys[i] = 0;
+    m->len--;
+}
+
+static int is_pid_dir(const char *s) {
+    if (!*s) return 0;
+    while (*s) { if (!isdigit((unsigned char)*s++)) return 0; }
+    return 1;
+}
+
+// Lee nombre y tiempo de inicio (campo 22) de /proc/PID/stat
+static int read_proc_identity(int pid, char *name, unsigned long long *start_time) {
+    char buf[1024], path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE *f = fopen(path, "r");
+    if (!f) return 0;
+    if (!fgets(buf, sizeof(buf), f)) { fclose(f); return 0; }
+    fclose(f);
+
+    char *s = strchr(buf, '('), *e = strrchr(buf, ')');
+    if (!s || !e) return 0;
+
+    size_t len = e - s - 1;
+    strncpy(name, s + 1, len);
+    name[len] = '\0';
+
+    if (sscanf(e + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %*u %*u %*d %*d %*d %*d %*d %*d %llu",
+               start_time) != 1)
+        return 0;
+    return 1;
+}
+
+// Quita del índice los sockets que aportó este proceso
+static void drop_inodes(owner_proc_t *p) {
+    for (size_t i = 0; i < p->n_inodes; i++) {
+        uint64_t v;
+        if (map_get(&by_inode, p->inodes[i], &v) && (int)(v >> 32) == p->pid)
+            map_del(&by_inode, p->inodes[i]);
+    }
+    p->n_inodes = 0;
+}
+
+static void scan_fds(owner_proc_t *p) {
+    char path[64];
+    drop_inodes(p);
+    snprintf(path, sizeof(path), "/proc/%d/fd", p->pid);
+    DIR *d = opendir(path);
+    if (!d) return;
+
+    struct dirent *e;
+    char link[64];
+    while ((e = readdir(d))) {
+        if (!is_pid_dir(e->d_name)) continue;
+        ssize_t n = readlinkat(dirfd(d), e->d_name, link, sizeof(link) - 1);
+        if (n <= 0) continue;
+        link[n] = '\0';
+        unsigned long inode;
+        if (sscanf(link, "socket:[%lu]", &inode) != 1) continue;
+
+        uint64_t v;
+        if (map_get(&by_inode, inode, &v)) continue;   // Compartido: gana el primero
+        map_put(&by_inode, inode, ((uint64_t)p->pid << 32) | (uint32_t)atoi(e->d_name));
+        if (p->n_inodes == p->cap_inodes) {
+            size_t cap = p->cap_inodes ? p->cap_inodes * 2 : 8;
+            unsigned long *ino = realloc(p->inodes, cap * sizeof(*ino));
+            if (!ino) break;
+            p->inodes = ino;
+            p->cap_inodes = cap;
+        }
+        p->inodes[p->n_inodes++] = inode;
+    }
+    closedir(d);
+}
+
+static void remove_proc(size_t idx) {
+    owner_proc_t *p = &procs[idx];
+    drop_inodes(p);
+    free(p->inodes);
+    map_del(&by_pid, p->pid);
+    if (idx != n_procs - 1) {
+        procs[idx] = procs[n_procs - 1];
+        map_put(&by_pid, procs[idx].pid, idx);
+    }
+    n_procs--;
+}
+
+static void refresh_locked(int force, owner_stats_t *stats) {
+    owner_stats_t st = {0};
+    generation++;
+
+    DIR *d = opendir("/proc");
+    if (!d) {
+        perror("opendir");
+        return;
+    }
+
+    struct dirent *e;
+    while ((e = readdir(d))) {
+        if (!is_pid_dir(e->d_name)) continue;
+
+        int pid = atoi(e->d_name);
+        char name[256], path[64];
+        unsigned long long start_time;
+        struct stat sb;
+        if (!read_proc_identity(pid, name, &start_time)) continue;
+        snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+        if (stat(path, &sb) != 0) continue;
+        st.procs++;
+
+        uint64_t idx;
+        owner_proc_t *p;
+        if (map_get(&by_pid, pid, &idx)) {
+            p = &procs[idx];
+            p->generation = generation;
+            strcpy(p->name, name);      // exec() cambia el nombre sin cambiar el PID
+            if (!force && p->start_time == start_time && p->fd_count == (long)sb.st_size)
+                continue;
+        } else {
+            if (n_procs == cap_procs) {
+                size_t cap = cap_procs ? cap_procs * 2 : 256;
+                owner_proc_t *np = realloc(procs, cap * sizeof(*np));
+                if (!np) break;
+                procs = np;
+                cap_procs = cap;
+            }
+            p = &procs[n_procs];
+            memset(p, 0, sizeof(*p));
+            p->pid = pid;
+            p->generation = generation;
+            map_put(&by_pid, pid, n_procs++);
+        }
+
+        // Nuevo, PID reutilizado o con descriptores distintos: releer fd/
+        p->start_time = start_time;
+        p->fd_count = sb.st_size;
+        strcpy(p->name, name);
+        scan_fds(p);
+        st.rescanned++;
+    }
+    closedir(d);
+
+    // Desalojar procesos que ya no existen
+    for (size_t i = 0; i < n_procs; ) {
+        if (procs[i].generation != generation) remove_proc(i);
+        else i++;
+    }
+
+    st.sockets = by_inode.len;
+    if (stats) *stats = st;
+}
+
+void owner_index_refresh(owner_stats_t *stats) {
+    pthread_mutex_lock(&lock);
+    refresh_locked(0, stats);
+    forced_since_refresh = 0;
+    pthread_mutex_unlock(&lock);
+}
+
+// Comprueba que el descriptor indexado sigue apuntando al mismo socket
+static int still_owned(int pid, int fd, unsigned long inode) {
+    char path[64], link[64], want[64];
+    snprintf(path, sizeof(path), "/proc/%d/fd/%d", pid, fd);
+    ssize_t n = readlink(path, link, sizeof(link) - 1);
+    if (n <= 0) return 0;
+    link[n] = '\0';
+    snprintf(want, sizeof(want), "socket:[%lu]", inode);
+    return strcmp(link, want) == 0;
+}
+
+int owner_lookup(unsigned long inode, char *name, size_t name_len) {
+    int pid = -1;
+    pthread_mutex_lock(&lock);
+    for (int attempt = 0; attempt < 2 && pid < 0; attempt++) {
+        uint64_t v, idx;
+        if (map_get(&by_inode, inode, &v) && still_owned((int)(v >> 32), (int)(uint32_t)v, inode)
+            && map_get(&by_pid, v >> 32, &idx)) {
+            pid = (int)(v >> 32);
+            snprintf(name, name_len, "%s", procs[idx].name);
+            break;
+        }
+        // Índice desactualizado: una sola pasada completa por refresco
+        if (forced_since_refresh) break;
+        forced_since_refresh = 1;
+        refresh_locked(1, NULL);
+    }
+    pthread_mutex_unlock(&lock);
+    return pid;
+}
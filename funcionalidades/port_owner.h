@@ -0,0 +1,22 @@
+#ifndef PORT_OWNER_H
+#define PORT_OWNER_H
+
+#include <stddef.h>
+
+typedef struct {
+    unsigned long procs;         // Procesos vivos en /proc
+    unsigned long rescanned;     // Procesos cuyo /proc/PID/fd se releyó
+    unsigned long sockets;       // Inodos de socket indexados
+} owner_stats_t;
+
+// Índice inodo de socket -> PID construido recorriendo /proc/*/fd. Se
+// conserva entre llamadas: cada refresco solo relee los PIDs nuevos o cuyo
+// directorio fd cambió (tiempo de inicio o número de descriptores).
+void owner_index_refresh(owner_stats_t *stats);
+
+// Devuelve el PID dueño del socket y su nombre (comm), o -1 si no se
+// encuentra. Si el índice está desactualizado hace una pasada completa.
+// Es seguro llamarla desde varios hilos.
+int owner_lookup(unsigned long inode, char *name, size_t name_len);
+
+#endif
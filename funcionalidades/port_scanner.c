@@ -2,117 +2,502 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <unistd.h>         // close()
+#include <ctype.h>
+#include <time.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
 #include <arpa/inet.h>      // inet_pton()
 #include <netinet/in.h>     // sockaddr_in
-#include <sys/socket.h>     // socket(), connect()
-#include <sys/time.h>       // timeval
+#include "port_engine.h"
+#include "port_targets.h"
+#include "port_local.h"
+#include "port_owner.h"
+#include "port_services.h"
+#include "port_baseline.h"
+#include "port_syn.h"
 
 #define TIMEOUT_SEC 1       // Timeout para conexión (segundos)
+#define MIN_TIMEOUT_MS 20   // Plazo mínimo cuando el RTT medido es muy bajo
 
+// Posición de cada objetivo en target_list_t, ordenado por dirección
 typedef struct {
-    int port;
-    const char *service;
-} port_service_t;
+    uint32_t addr;
+    uint32_t idx;
+} host_slot_t;
 
-static port_service_t common_services[] = {
-    {21, "FTP"},
-    {22, "SSH"},
-    {23, "Telnet"},
-    {25, "SMTP"},
-    {53, "DNS"},
-    {80, "HTTP"},
-    {110, "POP3"},
-    {143, "IMAP"},
-    {443, "HTTPS"},
-    {3306, "MySQL"},
-    {3389, "RDP"},
-    {5900, "VNC"},
-    {6379, "Redis"},
-    {8080, "HTTP-Alt"},
-};
+typedef struct {
+    const target_list_t *targets;
+    listener_list_t listeners;   // Sockets locales, solo si hay objetivos loopback
+    int have_listeners;
+    uint8_t **bitmaps;           // Modo vigilancia: se marcan los puertos en vez de imprimirlos
+    const host_slot_t *slots;
+    int syn;                     // Sondas SYN semiabiertas en vez de connect()
+} scan_ctx_t;
+
+// Imprime un puerto abierto con la clasificación de siempre. proto es ""
+// para TCP o "/udp"; where añade el host cuando hay varios objetivos, extra
+// el proceso dueño y/o el banner. Los puertos no comunes llevan entre
+// corchetes el nombre de /etc/services si lo tienen.
+static void print_open_port(int port, const char *proto, const char *where, const char *extra) {
+    const char* service = service_common(port);
+    if (service) {
+        printf(" [+] Puerto %d%s abierto%s (%s)%s\n", port, proto, where, service, extra);
+        return;
+    }
+    const char *registered = service_registered(port);
+    char hint[140] = "";
+    if (registered) snprintf(hint, sizeof(hint), " [%s]", registered);
+    printf(" [+] Puerto %d%s abierto%s (Servicio no común - posible puerta secreta!)%s%s\n",
+           port, proto, where, hint, extra);
+}
+
+// Añade a out el banner con los caracteres no imprimibles sustituidos
+static void append_banner(char *out, size_t len, const char *banner, int banner_len) {
+    char clean[81];
+    int n = 0;
+    for (int i = 0; i < banner_len && n < (int)sizeof(clean) - 1; i++) {
+        unsigned char c = banner[i];
+        if (c == '\r' || c == '\n') {
+            if (n > 0 && clean[n - 1] != ' ') clean[n++] = ' ';
+        } else {
+            clean[n++] = isprint(c) ? c : '.';
+        }
+    }
+    while (n > 0 && clean[n - 1] == ' ') n--;
+    clean[n] = '\0';
+    if (n == 0) return;
+    size_t used = strlen(out);
+    snprintf(out + used, len - used, " banner: \"%s\"", clean);
+}
+
+// Rellena owner con " - PID N (nombre)" si se conoce el dueño del socket
+static void describe_owner(unsigned long inode, char *owner, size_t len) {
+    char name[256];
+    owner[0] = '\0';
+    int pid = owner_lookup(inode, name, sizeof(name));
+    if (pid > 0) snprintf(owner, len, " - PID %d (%s)", pid, name);
+}
+
+static int is_loopback(const struct in_addr *addr) {
+    return (ntohl(addr->s_addr) >> 24) == 127;
+}
+
+// Busca el socket TCP local que atiende addr:port (dirección exacta o comodín)
+static const local_listener_t *find_listener(const listener_list_t *l, const struct in_addr *addr, int port) {
+    char ip[INET_ADDRSTRLEN];
+    inet_ntop(AF_INET, addr, ip, sizeof(ip));
+    for (size_t i = 0; i < l->count; i++) {
+        const local_listener_t *it = &l->items[i];
+        if (it->proto != IPPROTO_TCP || it->port != port) continue;
+        if (!strcmp(it->addr, ip) || !strcmp(it->addr, "0.0.0.0") || !strcmp(it->addr, "::"))
+            return it;
+    }
+    return NULL;
+}
 
-#define COMMON_SERVICES_COUNT (sizeof(common_services) / sizeof(common_services[0]))
+static int cmp_slot(const void *a, const void *b) {
+    uint32_t x = ((const host_slot_t *)a)->addr, y = ((const host_slot_t *)b)->addr;
+    return x < y ? -1 : x > y;
+}
 
-static int scan_port(const char *ip, int port) {
-    int sockfd;
-    struct sockaddr_in target_addr;
+// Marca el puerto en el bitmap del objetivo, creándolo si es el primero
+static void mark_open(scan_ctx_t *ctx, const struct in_addr *addr, int port) {
+    host_slot_t key = {.addr = ntohl(addr->s_addr)};
+    const host_slot_t *hit = bsearch(&key, ctx->slots, ctx->targets->count, sizeof(key), cmp_slot);
+    if (!hit) return;
 
-    sockfd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sockfd < 0) {
-        return 0;
+    uint8_t **slot = &ctx->bitmaps[hit->idx];
+    uint8_t *bits = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    if (!bits) {
+        uint8_t *fresh = calloc(1, BITMAP_BYTES), *expected = NULL;
+        if (!fresh) return;
+        if (__atomic_compare_exchange_n(slot, &expected, fresh, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+            bits = fresh;
+        } else {
+            free(fresh);             // Otro hilo lo creó antes
+            bits = expected;
+        }
     }
+    bitmap_set_atomic(bits, port);
+}
 
-    memset(&target_addr, 0, sizeof(target_addr));
-    target_addr.sin_family = AF_INET;
-    target_addr.sin_port = htons(port);
+static void print_result(const engine_result_t *res, void *arg) {
+    if (res->state != PORT_OPEN) return;
+    scan_ctx_t *ctx = arg;
+    const struct in_addr *addr = &res->addr;
+    int port = res->port;
 
-    if (inet_pton(AF_INET, ip, &target_addr.sin_addr) <= 0) {
-        close(sockfd);
-        return 0;
+    if (ctx->bitmaps) {
+        mark_open(ctx, addr, port);
+        return;
     }
 
-    struct timeval timeout = {TIMEOUT_SEC, 0};
-    setsockopt(sockfd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
-    setsockopt(sockfd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+    // Con un único objetivo se mantiene el formato de siempre
+    char where[INET_ADDRSTRLEN + 4] = "";
+    if (ctx->targets->count > 1) {
+        char ip[INET_ADDRSTRLEN];
+        inet_ntop(AF_INET, addr, ip, sizeof(ip));
+        snprintf(where, sizeof(where), " en %s", ip);
+    }
 
-    int result = connect(sockfd, (struct sockaddr *)&target_addr, sizeof(target_addr));
-    close(sockfd);
+    char extra[400] = "";
+    if (ctx->have_listeners && is_loopback(addr)) {
+        const local_listener_t *l = find_listener(&ctx->listeners, addr, port);
+        if (l) describe_owner(l->inode, extra, sizeof(extra));
+    }
+    append_banner(extra, sizeof(extra), res->banner, res->banner_len);
 
-    return result == 0;
+    print_open_port(port, "", where, extra);
+    fflush(stdout);
 }
 
-static const char* get_service_name(int port) {
-    for (int i = 0; i < COMMON_SERVICES_COUNT; i++) {
-        if (common_services[i].port == port) {
-            return common_services[i].service;
+// Auditoría local: lee los sockets en escucha del kernel sin enviar sondas
+static void scan_local(void) {
+    listener_list_t list;
+    struct timespec t0, t1;
+
+    printf("\nEnumerando puertos en escucha de esta máquina...\n\n");
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    if (local_listeners(&list) != 0) {
+        fprintf(stderr, "No se pudieron leer los sockets locales.\n");
+        return;
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ms = (t1.tv_sec - t0.tv_sec) * 1e3 + (t1.tv_nsec - t0.tv_nsec) / 1e6;
+
+    owner_stats_t ost;
+    owner_index_refresh(&ost);
+
+    // Un mismo puerto puede escuchar en IPv4 e IPv6: se informa una vez
+    size_t shown = 0;
+    for (size_t i = 0; i < list.count; i++) {
+        const local_listener_t *l = &list.items[i];
+        if (i > 0 && list.items[i - 1].proto == l->proto && list.items[i - 1].port == l->port)
+            continue;
+        char owner[300];
+        describe_owner(l->inode, owner, sizeof(owner));
+        print_open_port(l->port, l->proto == IPPROTO_UDP ? "/udp" : "", "", owner);
+        shown++;
+    }
+
+    printf("\nEscaneo finalizado: %zu puertos en escucha (%zu sockets) leídos de %s en %.2f ms.\n",
+           shown, list.count, list.source, ms);
+    printf("Índice de sockets: %lu procesos, %lu releídos, %lu sockets.\n",
+           ost.procs, ost.rescanned, ost.sockets);
+    listeners_free(&list);
+}
+
+// Relee los sockets locales si algún objetivo es loopback, para poder
+// nombrar el proceso dueño de cada puerto
+static void refresh_listeners(scan_ctx_t *ctx) {
+    if (ctx->have_listeners) {
+        listeners_free(&ctx->listeners);
+        ctx->have_listeners = 0;
+    }
+    for (size_t i = 0; i < ctx->targets->count; i++) {
+        if (!is_loopback(&ctx->targets->hosts[i])) continue;
+        if (local_listeners(&ctx->listeners) == 0) {
+            ctx->have_listeners = 1;
+            owner_index_refresh(NULL);
         }
+        break;
     }
-    return NULL;
 }
 
-void port_scan(void) {
-    int start_port, end_port;
+static double elapsed_since(const struct timespec *t0) {
+    struct timespec t1;
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    return (t1.tv_sec - t0->tv_sec) + (t1.tv_nsec - t0->tv_nsec) / 1e9;
+}
+
+// Espera hasta ms milisegundos atendiendo el teclado. Devuelve 1 si se pulsó 'q'.
+static int wait_for_quit(long ms, int *stdin_open) {
+    struct pollfd pfd = {.fd = STDIN_FILENO, .events = POLLIN};
+    struct timespec t0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (;;) {
+        long left = ms - (long)(elapsed_since(&t0) * 1000);
+        if (left <= 0) return 0;
+        if (!*stdin_open) {
+            poll(NULL, 0, (int)left);
+            return 0;
+        }
+        if (poll(&pfd, 1, (int)left) <= 0) continue;
+        char c;
+        ssize_t n = read(STDIN_FILENO, &c, 1);
+        if (n <= 0) *stdin_open = 0;       // Entrada cerrada: solo queda esperar
+        else if (c == 'q' || c == 'Q') return 1;
+    }
+}
+
+// Compara la pasada actual con la línea base de cada objetivo, informa solo
+// de los puertos que se abrieron o cerraron y guarda la nueva línea base.
+// mask limita la comparación a los puertos escaneados. Devuelve el número
+// de cambios.
+static int report_changes(scan_ctx_t *ctx, uint8_t **baseline, const uint8_t *mask) {
+    const target_list_t *targets = ctx->targets;
+    static const uint8_t zeros[BITMAP_BYTES];
+    int total = 0;
+    for (size_t h = 0; h < targets->count; h++) {
+        const uint8_t *cur = ctx->bitmaps[h] ? ctx->bitmaps[h] : zeros;
+        const uint8_t *old = baseline[h] ? baseline[h] : zeros;
+        if (cur == zeros && old == zeros) continue;
 
-    // Solicitar puerto inicial
-    printf("Introduce puerto inicial (1-65535): ");
-    if (scanf("%d", &start_port) != 1) {
-        fprintf(stderr, "Entrada inválida para puerto inicial.\n");
+        char ip[INET_ADDRSTRLEN], where[INET_ADDRSTRLEN + 4];
+        inet_ntop(AF_INET, &targets->hosts[h], ip, sizeof(ip));
+        snprintf(where, sizeof(where), " en %s", ip);
+
+        int changed = 0;
+        for (int byte = 0; byte < BITMAP_BYTES; byte++) {
+            uint8_t diff = (cur[byte] ^ old[byte]) & mask[byte];
+            for (int bit = 0; diff; bit++, diff >>= 1) {
+                if (!(diff & 1)) continue;
+                int port = byte * 8 + bit;
+                changed = 1;
+                total++;
+                if (bitmap_test(cur, port)) {
+                    char extra[400] = "";
+                    if (ctx->have_listeners && is_loopback(&targets->hosts[h])) {
+                        const local_listener_t *l = find_listener(&ctx->listeners, &targets->hosts[h], port);
+                        if (l) describe_owner(l->inode, extra, sizeof(extra));
+                    }
+                    print_open_port(port, "", where, extra);
+                } else {
+                    printf(" [-] Puerto %d cerrado%s\n", port, where);
+                }
+            }
+        }
+        if (!changed) continue;
+
+        if (!baseline[h] && !(baseline[h] = calloc(1, BITMAP_BYTES))) continue;
+        for (int byte = 0; byte < BITMAP_BYTES; byte++)
+            baseline[h][byte] = (baseline[h][byte] & ~mask[byte]) | (cur[byte] & mask[byte]);
+        if (baseline_save(targets->hosts[h], baseline[h]) != 0)
+            fprintf(stderr, "No se pudo guardar la línea base de %s.\n", ip);
+    }
+    return total;
+}
+
+// Lanza las sondas del plan con el motor elegido. Sin CAP_NET_RAW el
+// escaneo SYN no es posible: se avisa una vez y se sigue con connect().
+static int run_probes(scan_ctx_t *ctx, const engine_config_t *cfg, scan_plan_t *plan, engine_stats_t *stats) {
+    if (ctx->syn) {
+        int rc = syn_run(cfg, plan_next, plan, print_result, ctx, stats);
+        if (rc != SYN_NO_PRIVILEGE) return rc;
+        fprintf(stderr, "Sin CAP_NET_RAW no se puede hacer escaneo SYN: se usa connect().\n");
+        ctx->syn = 0;
+    }
+    return engine_run_pool(cfg, plan_next, plan, print_result, ctx, stats);
+}
+
+// Vigilancia continua: reescanea cada interval_s segundos e informa solo de
+// diferencias frente a la línea base guardada en disco (8 KB por objetivo).
+static void watch_network(scan_ctx_t *ctx, const port_set_t *ports,
+                          const engine_config_t *cfg, int interval_s) {
+    const target_list_t *targets = ctx->targets;
+    size_t n = targets->count;
+    uint8_t **baseline = calloc(n, sizeof(uint8_t *));
+    host_slot_t *slots = malloc(n * sizeof(host_slot_t));
+    uint8_t *mask = calloc(1, BITMAP_BYTES);
+    ctx->bitmaps = calloc(n, sizeof(uint8_t *));
+    if (!baseline || !slots || !mask || !ctx->bitmaps) {
+        fprintf(stderr, "Memoria insuficiente para la vigilancia.\n");
+        goto out;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        slots[i].addr = ntohl(targets->hosts[i].s_addr);
+        slots[i].idx = i;
+    }
+    qsort(slots, n, sizeof(*slots), cmp_slot);
+    ctx->slots = slots;
+    for (size_t i = 0; i < ports->count; i++) mask[ports->ports[i] >> 3] |= 1 << (ports->ports[i] & 7);
+
+    // Cargar las líneas base existentes
+    size_t loaded = 0;
+    uint8_t buf[BITMAP_BYTES];
+    for (size_t i = 0; i < n; i++) {
+        if (baseline_load(targets->hosts[i], buf) != 1) continue;
+        if ((baseline[i] = malloc(BITMAP_BYTES))) memcpy(baseline[i], buf, BITMAP_BYTES);
+        loaded++;
+    }
+
+    printf("\nVigilando %zu puertos TCP en %zu host(s) cada %d s (%zu líneas base cargadas).\n",
+           ports->count, n, interval_s, loaded);
+    printf("Solo se muestran los cambios. Presione 'q' para finalizar.\n\n");
+
+    struct termios oldt, newt;
+    int is_tty = tcgetattr(STDIN_FILENO, &oldt) == 0;
+    if (is_tty) {
+        newt = oldt;
+        newt.c_lflag &= ~(ICANON | ECHO);
+        tcsetattr(STDIN_FILENO, TCSANOW, &newt);
+    }
+
+    int stdin_open = 1;
+    for (unsigned long pass = 1; ; pass++) {
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+
+        for (size_t i = 0; i < n; i++) {
+            free(ctx->bitmaps[i]);
+            ctx->bitmaps[i] = NULL;
+        }
+        scan_plan_t plan;
+        plan_init(&plan, targets, ports);
+        engine_stats_t stats;
+        if (run_probes(ctx, cfg, &plan, &stats) != 0) {
+            fprintf(stderr, "No se pudo iniciar el motor de escaneo.\n");
+            break;
+        }
+
+        refresh_listeners(ctx);
+        if (report_changes(ctx, baseline, mask) > 0) {
+            printf(" -- pasada %lu: %lu abiertos en %.2f s\n", pass, stats.open, elapsed_since(&t0));
+            fflush(stdout);
+        }
+
+        long left = interval_s * 1000L - (long)(elapsed_since(&t0) * 1000);
+        if (wait_for_quit(left > 0 ? left : 0, &stdin_open)) break;
+    }
+
+    if (is_tty) tcsetattr(STDIN_FILENO, TCSANOW, &oldt);
+    printf("\nVigilancia finalizada.\n");
+
+out:
+    for (size_t i = 0; ctx->bitmaps && i < n; i++) free(ctx->bitmaps[i]);
+    for (size_t i = 0; baseline && i < n; i++) free(baseline[i]);
+    free(ctx->bitmaps);
+    ctx->bitmaps = NULL;
+    free(baseline);
+    free(slots);
+    free(mask);
+}
+
+// Resumen de tiempos de espera por sonda y de los plazos adaptativos
+static void print_wait_stats(const engine_stats_t *stats) {
+    unsigned long waits = 0;
+    for (int b = 0; b < ENGINE_WAIT_BUCKETS; b++) waits += stats->wait_hist[b];
+    if (!waits) return;
+    printf("Espera por sonda: media %.2f ms, p50 %.2f ms, p95 %.2f ms, p99 %.2f ms, máx %.2f ms; %lu sin respuesta.\n",
+           stats->wait_total_us / 1000.0 / waits,
+           engine_wait_percentile(stats, 0.50) / 1000.0,
+           engine_wait_percentile(stats, 0.95) / 1000.0,
+           engine_wait_percentile(stats, 0.99) / 1000.0,
+           stats->wait_max_us / 1000.0, stats->timeouts);
+    if (stats->hosts_measured)
+        printf("Plazo adaptativo final: %.2f - %.2f ms (%lu host(s) con RTT medido).\n",
+               stats->rto_min_us / 1000.0, stats->rto_max_us / 1000.0, stats->hosts_measured);
+}
+
+static void scan_network(int syn) {
+    char target_spec[1024], port_spec[1024];
+    int inflight, workers = 0, banner_ms = 0, interval_s;
+
+    // Solicitar objetivos
+    printf("Objetivos (IPs, nombres o rangos CIDR separados por comas): ");
+    if (scanf(" %1023[^\n]", target_spec) != 1) {
+        fprintf(stderr, "Entrada inválida para objetivos.\n");
         return;
     }
 
-    // Solicitar puerto final
-    printf("Introduce puerto final (1-65535): ");
-    if (scanf("%d", &end_port) != 1) {
-        fprintf(stderr, "Entrada inválida para puerto final.\n");
+    // Solicitar puertos
+    printf("Puertos (1-65535, ej. 1-1024,3306,8080): ");
+    if (scanf(" %1023[^\n]", port_spec) != 1) {
+        fprintf(stderr, "Entrada inválida para puertos.\n");
         return;
     }
 
-    // Validar rango de puertos
-    if (start_port < 1 || start_port > 65535 || end_port < 1 || end_port > 65535) {
-        fprintf(stderr, "Los puertos deben estar entre 1 y 65535.\n");
+    // Solicitar concurrencia e hilos (0 = valor por defecto)
+    printf("Conexiones simultáneas (0 = %d): ", syn ? SYN_DEFAULT_INFLIGHT : ENGINE_DEFAULT_INFLIGHT);
+    if (scanf("%d", &inflight) != 1 || inflight < 0) {
+        fprintf(stderr, "Entrada inválida para conexiones simultáneas.\n");
+        return;
+    }
+    // El escaneo SYN usa un solo emisor y no completa conexiones
+    if (!syn) {
+        printf("Hilos de trabajo (0 = uno por CPU): ");
+        if (scanf("%d", &workers) != 1 || workers < 0) {
+            fprintf(stderr, "Entrada inválida para hilos de trabajo.\n");
+            return;
+        }
+    }
+    printf("Vigilancia continua (segundos entre pasadas, 0 = escaneo único): ");
+    if (scanf("%d", &interval_s) != 1 || interval_s < 0) {
+        fprintf(stderr, "Entrada inválida para el intervalo.\n");
         return;
     }
+    if (interval_s == 0 && !syn) {
+        printf("Capturar banners (ms de espera por puerto, 0 = no): ");
+        if (scanf("%d", &banner_ms) != 1 || banner_ms < 0) {
+            fprintf(stderr, "Entrada inválida para la espera de banners.\n");
+            return;
+        }
+    }
 
-    if (start_port > end_port) {
-        fprintf(stderr, "El puerto inicial no puede ser mayor que el final.\n");
+    target_list_t targets;
+    port_set_t ports;
+    if (targets_parse(target_spec, &targets) != 0) return;
+    if (ports_parse(port_spec, &ports) != 0) {
+        targets_free(&targets);
         return;
     }
 
-    const char *target_ip = "127.0.0.1";
+    // Para objetivos loopback se puede nombrar el proceso dueño de cada puerto
+    scan_ctx_t ctx = {.targets = &targets, .syn = syn};
+    refresh_listeners(&ctx);
 
-    printf("\nEscaneando puertos TCP en %s del %d al %d...\n\n", target_ip, start_port, end_port);
+    engine_config_t cfg = {
+        .max_inflight = inflight,
+        .timeout_ms = TIMEOUT_SEC * 1000,
+        .min_timeout_ms = MIN_TIMEOUT_MS,
+        .hosts_hint = (int)targets.count,
+        .workers = workers,
+        .banner_ms = banner_ms,
+    };
 
-    for (int port = start_port; port <= end_port; port++) {
-        if (scan_port(target_ip, port)) {
-            const char* service = get_service_name(port);
-            if (service) {
-                printf(" [+] Puerto %d abierto (%s)\n", port, service);
-            } else {
-                printf(" [+] Puerto %d abierto (Servicio no común - posible puerta secreta!)\n", port);
-            }
+    if (interval_s > 0) {
+        watch_network(&ctx, &ports, &cfg, interval_s);
+    } else {
+        scan_plan_t plan;
+        plan_init(&plan, &targets, &ports);
+        engine_stats_t stats;
+
+        printf("\nEscaneando %zu puertos TCP en %zu host(s) (%lu sondas%s)...\n\n",
+               ports.count, targets.count, plan.total, syn ? ", SYN semiabierto" : "");
+
+        struct timespec t0;
+        clock_gettime(CLOCK_MONOTONIC, &t0);
+        int rc = run_probes(&ctx, &cfg, &plan, &stats);
+        double secs = elapsed_since(&t0);
+
+        if (rc != 0) {
+            fprintf(stderr, "No se pudo iniciar el motor de escaneo.\n");
+        } else {
+            printf("\nEscaneo finalizado: %lu abiertos, %lu cerrados, %lu filtrados en %.2f s.\n",
+                   stats.open, stats.closed, stats.filtered, secs);
+            print_wait_stats(&stats);
         }
     }
 
-    printf("\nEscaneo finalizado.\n");
+    if (ctx.have_listeners) listeners_free(&ctx.listeners);
+    ports_free(&ports);
+    targets_free(&targets);
+}
+
+void port_scan(void) {
+    int mode;
+
+    services_init();
+
+    printf("Modo (1 = escaneo de red, 2 = auditoría local sin sondas, 3 = escaneo SYN semiabierto): ");
+    if (scanf("%d", &mode) != 1 || mode < 1 || mode > 3) {
+        fprintf(stderr, "Modo inválido.\n");
+        return;
+    }
+
+    if (mode == 2) scan_local();
+    else scan_network(mode == 3);
 }
\ No newline at end of file
@@ -0,0 +1,101 @@
+#define _GNU_SOURCE
+#include "port_services.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+
+#define SERVICES_FILE "/etc/services"
+#define MAX_SERVICE_NAMES 8192
+
+typedef struct {
+    int port;
+    const char *service;
+} port_service_t;
+
+static port_service_t common_services[] = {
+    {21, "FTP"},
+    {22, "SSH"},
+    {23, "Telnet"},
+    {25, "SMTP"},
+    {53, "DNS"},
+    {80, "HTTP"},
+    {110, "POP3"},
+    {143, "IMAP"},
+    {443, "HTTPS"},
+    {3306, "MySQL"},
+    {3389, "RDP"},
+    {5900, "VNC"},
+    {6379, "Redis"},
+    {8080, "HTTP-Alt"},
+};
+
+#define COMMON_SERVICES_COUNT (sizeof(common_services) / sizeof(common_services[0]))
+
+// Cada puerto guarda un índice (1..n) en la tabla de nombres; 0 = sin nombre
+static uint16_t common_index[65536];
+static uint16_t tcp_index[65536];
+static uint16_t udp_index[65536];
+static const char *names[MAX_SERVICE_NAMES];
+static int n_names = 1;
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+
+static uint16_t add_name(const char *name) {
+    if (n_names >= MAX_SERVICE_NAMES) return 0;
+    names[n_names] = name;
+    return (uint16_t)n_names++;
+}
+
+static void load_services_file(void) {
+    FILE *f = fopen(SERVICES_FILE, "r");
+    if (!f) return;
+
+    char line[512], name[128], proto[16];
+    int port;
+    while (fgets(line, sizeof(line), f)) {
+        char *hash = strchr(line, '#');
+        if (hash) *hash = '\0';
+        if (sscanf(line, "%127s %d/%15s", name, &port, proto) != 3) continue;
+        if (port < 1 || port > 65535) continue;
+
+        uint16_t *table;
+        if (strcmp(proto, "tcp") == 0) table = tcp_index;
+        else if (strcmp(proto, "udp") == 0) table = udp_index;
+        else continue;
+        if (table[port]) continue;       // La primera entrada gana, como en getservbyport()
+
+        char *copy = strdup(name);
+        if (!copy) break;
+        uint16_t idx = add_name(copy);
+        if (!idx) {
+            free(copy);
+            break;
+        }
+        table[port] = idx;
+    }
+    fclose(f);
+}
+
+static void build_tables(void) {
+    for (size_t i = 0; i < COMMON_SERVICES_COUNT; i++)
+        common_index[common_services[i].port] = add_name(common_services[i].service);
+    load_services_file();
+}
+
+void services_init(void) {
+    pthread_once(&once, build_tables);
+}
+
+const char *service_common(int port) {
+    if (port < 0 || port > 65535) return NULL;
+    services_init();
+    return common_index[port] ? names[common_index[port]] : NULL;
+}
+
+const char *service_registered(int port) {
+    if (port < 0 || port > 65535) return NULL;
+    services_init();
+    uint16_t idx = tcp_index[port] ? tcp_index[port] : udp_index[port];
+    return idx ? names[idx] : NULL;
+}
@@ -0,0 +1,15 @@
+#ifndef PORT_SERVICES_H
+#define PORT_SERVICES_H
+
+// Tabla de servicios indexada directamente por puerto (65536 entradas),
+// construida una sola vez a partir de la lista interna y de /etc/services.
+void services_init(void);
+
+// Nombre del servicio conocido en la lista interna, o NULL si el puerto no
+// es de un servicio común (posible puerta secreta).
+const char *service_common(int port);
+
+// Nombre registrado en /etc/services (TCP con preferencia sobre UDP), o NULL
+const char *service_registered(int port);
+
+#endif
@@ -0,0 +1,479 @@
+#define _GNU_SOURCE
+#include "port_syn.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+
+#define SYN_RETRIES 1        // Reenvíos antes de dar una sonda por filtrada
+#define SYN_BATCH 256        // SYN por ráfaga como máximo
+#define SYN_RCVBUF (4 << 20) // Búfer de recepción del socket raw
+#define SYN_POLL_MS 20
+
+typedef struct {
+    uint32_t addr;           // Orden de red; 0 = ranura libre
+    uint16_t port;
+    uint8_t tries;
+    long deadline_us;
+    int heap_pos;
+} syn_probe_t;
+
+// Índice (dirección, puerto) -> ranura con sondeo lineal. Capacidad fija
+// (el doble de ranuras) y borrado con desplazamiento hacia atrás.
+typedef struct {
+    uint64_t *keys;          // 0 = celda vacía (el puerto nunca es 0)
+    int *slots;
+    size_t cap;              // Potencia de dos
+} probe_index_t;
+
+// Caché de la dirección origen que usa el kernel para cada objetivo
+typedef struct {
+    uint32_t *dst;           // 0 = celda vacía
+    uint32_t *src;           // 0 = sin ruta
+    size_t cap;
+} route_cache_t;
+
+typedef struct {
+    int raw;
+    uint16_t sport;          // Puerto origen reservado, orden de host
+    uint32_t secret;
+    long timeout_us;
+
+    pthread_mutex_t lock;    // Protege todo lo siguiente
+    syn_probe_t *probes;
+    int *free_list;
+    int free_count;
+    int *heap;               // Montículo mínimo de ranuras ordenado por plazo
+    int heap_len;
+    probe_index_t index;
+    engine_stats_t *stats;
+
+    engine_result_fn on_result;
+    void *ctx;
+    int stop;
+} syn_state_t;
+
+static long now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000L + ts.tv_nsec / 1000L;
+}
+
+static size_t hash64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return (size_t)k;
+}
+
+static uint64_t probe_key(uint32_t addr, uint16_t port) {
+    return (uint64_t)addr << 16 | port;
+}
+
+// Número de secuencia del SYN: permite validar la respuesta (ack = seq + 1)
+// sin guardarlo y descartar paquetes que no son nuestros.
+static uint32_t syn_cookie(const syn_state_t *s, uint32_t addr, uint16_t port) {
+    return (uint32_t)hash64(probe_key(addr, port) ^ ((uint64_t)s->secret << 32 | s->secret));
+}
+
+// --- Índice de sondas en vuelo ---
+static size_t index_slot(const probe_index_t *m, uint64_t key) {
+    size_t i = hash64(key) & (m->cap - 1);
+    while (m->keys[i] && m->keys[i] != key) i = (i + 1) & (m->cap - 1);
+    return i;
+}
+
+static int index_get(const probe_index_t *m, uint64_t key) {
+    size_t i = index_slot(m, key);
+    return m->keys[i] ? m->slots[i] : -1;
+}
+
+static void index_put(probe_index_t *m, uint64_t key, int slot) {
+    size_t i = index_slot(m, key);
+    m->keys[i] = key;
+    m->slots[i] = slot;
+}
+
+static void index_del(probe_index_t *m, uint64_t key) {
+    size_t i = index_slot(m, key);
+    if (!m->keys[i]) return;
+    size_t mask = m->cap - 1;
+    for (size_t j = (i + 1) & mask; m->keys[j]; j = (j + 1) & mask) {
+        size_t home = hash64(m->keys[j]) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            m->keys[i] = m->keys[j];
+            m->slots[i] = m->slots[j];
+            i = j;
+        }
+    }
+    m->keys[i] = 0;
+}
+
+// --- Montículo de plazos ---
+static void heap_swap(syn_state_t *s, int a, int b) {
+    int t = s->heap[a];
+    s->heap[a] = s->heap[b];
+    s->heap[b] = t;
+    s->probes[s->heap[a]].heap_pos = a;
+    s->probes[s->heap[b]].heap_pos = b;
+}
+
+static void heap_up(syn_state_t *s, int i) {
+    while (i > 0) {
+        int p = (i - 1) / 2;
+        if (s->probes[s->heap[p]].deadline_us <= s->probes[s->heap[i]].deadline_us) break;
+        heap_swap(s, i, p);
+        i = p;
+    }
+}
+
+static void heap_down(syn_state_t *s, int i) {
+    for (;;) {
+        int l = 2 * i + 1, r = l + 1, m = i;
+        if (l < s->heap_len && s->probes[s->heap[l]].deadline_us < s->probes[s->heap[m]].deadline_us) m = l;
+        if (r < s->heap_len && s->probes[s->heap[r]].deadline_us < s->probes[s->heap[m]].deadline_us) m = r;
+        if (m == i) break;
+        heap_swap(s, i, m);
+        i = m;
+    }
+}
+
+static void heap_remove(syn_state_t *s, int slot) {
+    int i = s->probes[slot].heap_pos;
+    s->heap_len--;
+    if (i != s->heap_len) {
+        heap_swap(s, i, s->heap_len);
+        heap_down(s, i);
+        heap_up(s, i);
+    }
+}
+
+// Saca la sonda del índice y del montículo y libera la ranura. Con el lock.
+static void release_probe(syn_state_t *s, int slot) {
+    syn_probe_t *p = &s->probes[slot];
+    index_del(&s->index, probe_key(p->addr, p->port));
+    heap_remove(s, slot);
+    p->addr = 0;
+    s->free_list[s->free_count++] = slot;
+}
+
+static void report(syn_state_t *s, uint32_t addr, int port, port_state_t state) {
+    if (!s->on_result) return;
+    engine_result_t res = {
+        .addr = {.s_addr = addr},
+        .port = port,
+        .state = state,
+    };
+    s->on_result(&res, s->ctx);
+}
+
+// --- Rutas ---
+// Dirección origen que el kernel usaría hacia dst: se conecta un socket UDP
+// (no envía nada) y se lee su dirección local. Devuelve 0 si no hay ruta.
+static uint32_t route_source(uint32_t dst) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return 0;
+    struct sockaddr_in sa = {.sin_family = AF_INET, .sin_port = htons(9), .sin_addr.s_addr = dst};
+    socklen_t len = sizeof(sa);
+    uint32_t src = 0;
+    if (connect(fd, (struct sockaddr *)&sa, sizeof(sa)) == 0
+        && getsockname(fd, (struct sockaddr *)&sa, &len) == 0)
+        src = sa.sin_addr.s_addr;
+    close(fd);
+    return src;
+}
+
+static uint32_t route_lookup(route_cache_t *c, uint32_t dst) {
+    size_t mask = c->cap - 1;
+    size_t i = hash64(dst) & mask;
+    for (size_t probes = 0; probes < c->cap; probes++, i = (i + 1) & mask) {
+        if (c->dst[i] == dst) return c->src[i];
+        if (!c->dst[i]) {
+            c->dst[i] = dst;
+            return c->src[i] = route_source(dst);
+        }
+    }
+    return route_source(dst);    // Caché llena: se consulta sin guardar
+}
+
+// --- Paquetes ---
+static uint16_t checksum(const void *data, size_t len, uint32_t sum) {
+    const uint8_t *p = data;
+    for (; len > 1; p += 2, len -= 2) sum += (uint32_t)p[0] << 8 | p[1];
+    if (len) sum += (uint32_t)p[0] << 8;
+    while (sum >> 16) sum = (sum & 0xffff) + (sum >> 16);
+    return htons(~sum & 0xffff);
+}
+
+// Envía un SYN con la opción MSS, como el de un cliente normal
+static int send_syn(syn_state_t *s, uint32_t src, uint32_t dst, uint16_t port) {
+    uint8_t pkt[sizeof(struct tcphdr) + 4];
+    struct tcphdr *th = (struct tcphdr *)pkt;
+    memset(pkt, 0, sizeof(pkt));
+    th->source = htons(s->sport);
+    th->dest = htons(port);
+    th->seq = htonl(syn_cookie(s, dst, port));
+    th->doff = sizeof(pkt) / 4;
+    th->syn = 1;
+    th->window = htons(1024);
+    uint8_t *opt = pkt + sizeof(struct tcphdr);
+    opt[0] = 2;                          // MSS
+    opt[1] = 4;
+    opt[2] = 1460 >> 8;
+    opt[3] = 1460 & 0xff;
+
+    // Pseudo-cabecera: origen, destino, protocolo y longitud TCP
+    uint32_t sum = 0;
+    uint32_t s_h = ntohl(src), d_h = ntohl(dst);
+    sum += (s_h >> 16) + (s_h & 0xffff) + (d_h >> 16) + (d_h & 0xffff);
+    sum += IPPROTO_TCP + sizeof(pkt);
+    th->check = checksum(pkt, sizeof(pkt), sum);
+
+    struct sockaddr_in to = {.sin_family = AF_INET, .sin_addr.s_addr = dst};
+    for (int attempt = 0; attempt < 3; attempt++) {
+        if (sendto(s->raw, pkt, sizeof(pkt), 0, (struct sockaddr *)&to, sizeof(to)) == (ssize_t)sizeof(pkt))
+            return 0;
+        if (errno != ENOBUFS && errno != EAGAIN) return -1;
+        struct timespec pause = {0, 200000};   // Cola de salida llena: esperar un poco
+        nanosleep(&pause, NULL);
+    }
+    return -1;
+}
+
+// --- Receptor ---
+static void handle_packet(syn_state_t *s, const uint8_t *buf, ssize_t len) {
+    if (len < (ssize_t)sizeof(struct iphdr)) return;
+    const struct iphdr *ip = (const struct iphdr *)buf;
+    size_t ihl = ip->ihl * 4;
+    if (ip->protocol != IPPROTO_TCP || len < (ssize_t)(ihl + sizeof(struct tcphdr))) return;
+    const struct tcphdr *th = (const struct tcphdr *)(buf + ihl);
+    if (ntohs(th->dest) != s->sport || !th->ack) return;
+
+    port_state_t state;
+    if (th->syn) state = PORT_OPEN;
+    else if (th->rst) state = PORT_CLOSED;
+    else return;
+
+    uint32_t addr = ip->saddr;
+    uint16_t port = ntohs(th->source);
+    if (ntohl(th->ack_seq) != syn_cookie(s, addr, port) + 1) return;
+
+    pthread_mutex_lock(&s->lock);
+    int slot = index_get(&s->index, probe_key(addr, port));
+    if (slot >= 0) {
+        release_probe(s, slot);
+        if (state == PORT_OPEN) s->stats->open++;
+        else s->stats->closed++;
+    }
+    pthread_mutex_unlock(&s->lock);
+    // Las respuestas duplicadas o tardías ya no están en el índice
+    if (slot >= 0) report(s, addr, port, state);
+}
+
+static void *receiver(void *arg) {
+    syn_state_t *s = arg;
+    uint8_t buf[2048];
+    struct pollfd pfd = {.fd = s->raw, .events = POLLIN};
+    while (!__atomic_load_n(&s->stop, __ATOMIC_ACQUIRE)) {
+        if (poll(&pfd, 1, SYN_POLL_MS) <= 0) continue;
+        ssize_t n;
+        while ((n = recv(s->raw, buf, sizeof(buf), MSG_DONTWAIT)) > 0) handle_packet(s, buf, n);
+    }
+    return NULL;
+}
+
+// --- Emisor ---
+// Expira las sondas vencidas: las que aún tienen reintentos se reenvían con
+// un plazo nuevo y el resto se informan como filtradas.
+static void expire(syn_state_t *s, route_cache_t *routes) {
+    struct { uint32_t addr; uint16_t port; int resend; } due[SYN_BATCH];
+    int n = 0;
+    long now = now_us();
+
+    pthread_mutex_lock(&s->lock);
+    while (n < SYN_BATCH && s->heap_len > 0 && s->probes[s->heap[0]].deadline_us <= now) {
+        int slot = s->heap[0];
+        syn_probe_t *p = &s->probes[slot];
+        due[n].addr = p->addr;
+        due[n].port = p->port;
+        due[n].resend = p->tries <= SYN_RETRIES;
+        if (due[n].resend) {
+            p->tries++;
+            p->deadline_us = now + s->timeout_us;
+            heap_down(s, 0);
+        } else {
+            release_probe(s, slot);
+            s->stats->filtered++;
+            s->stats->timeouts++;
+        }
+        n++;
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    for (int i = 0; i < n; i++) {
+        if (due[i].resend) {
+            send_syn(s, route_lookup(routes, due[i].addr), due[i].addr, due[i].port);
+            s->stats->sent++;
+        } else {
+            report(s, due[i].addr, due[i].port, PORT_FILTERED);
+        }
+    }
+}
+
+// Reserva un puerto origen con un socket TCP sin escuchar: el kernel no lo
+// dará a otras conexiones y contestará RST a los SYN-ACK que reciba.
+static int reserve_port(uint16_t *port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+    struct sockaddr_in sa = {.sin_family = AF_INET};
+    socklen_t len = sizeof(sa);
+    if (bind(fd, (struct sockaddr *)&sa, sizeof(sa)) != 0
+        || getsockname(fd, (struct sockaddr *)&sa, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(sa.sin_port);
+    return fd;
+}
+
+int syn_run(const engine_config_t *cfg, engine_next_fn next, void *src,
+            engine_result_fn on_result, void *ctx, engine_stats_t *stats) {
+    engine_stats_t local_stats;
+    if (!stats) stats = &local_stats;
+    memset(stats, 0, sizeof(*stats));
+
+    int raw = socket(AF_INET, SOCK_RAW | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (raw < 0) return errno == EPERM || errno == EACCES ? SYN_NO_PRIVILEGE : -1;
+    int rcvbuf = SYN_RCVBUF;
+    setsockopt(raw, SOL_SOCKET, SO_RCVBUFFORCE, &rcvbuf, sizeof(rcvbuf));
+
+    syn_state_t s;
+    memset(&s, 0, sizeof(s));
+    s.raw = raw;
+    s.stats = stats;
+    s.on_result = on_result;
+    s.ctx = ctx;
+    s.timeout_us = (cfg->timeout_ms > 0 ? cfg->timeout_ms : ENGINE_DEFAULT_TIMEOUT_MS) * 1000L;
+    int reserved = reserve_port(&s.sport);
+
+    int inflight = cfg->max_inflight > 0 ? cfg->max_inflight : SYN_DEFAULT_INFLIGHT;
+    long rate = cfg->rate_pps > 0 ? cfg->rate_pps : SYN_DEFAULT_RATE;
+    s.index.cap = 64;
+    while (s.index.cap < (size_t)inflight * 2) s.index.cap <<= 1;
+    route_cache_t routes = {.cap = 64};
+    while (routes.cap < (size_t)(cfg->hosts_hint > 0 ? cfg->hosts_hint : 1) * 2) routes.cap <<= 1;
+
+    s.probes = calloc(inflight, sizeof(syn_probe_t));
+    s.free_list = malloc(inflight * sizeof(int));
+    s.heap = malloc(inflight * sizeof(int));
+    s.index.keys = calloc(s.index.cap, sizeof(uint64_t));
+    s.index.slots = malloc(s.index.cap * sizeof(int));
+    routes.dst = calloc(routes.cap, sizeof(uint32_t));
+    routes.src = calloc(routes.cap, sizeof(uint32_t));
+
+    int rc = -1;
+    pthread_t th;
+    if (reserved < 0 || !s.probes || !s.free_list || !s.heap || !s.index.keys || !s.index.slots
+        || !routes.dst || !routes.src)
+        goto out;
+    s.free_count = inflight;
+    for (int i = 0; i < inflight; i++) s.free_list[i] = inflight - 1 - i;
+    if (getentropy(&s.secret, sizeof(s.secret)) != 0) s.secret = (uint32_t)now_us() ^ (uint32_t)getpid();
+    pthread_mutex_init(&s.lock, NULL);
+    if (pthread_create(&th, NULL, receiver, &s) != 0) {
+        pthread_mutex_destroy(&s.lock);
+        goto out;
+    }
+
+    // Cubo de fichas para acompasar el envío a rate SYN por segundo
+    double tokens = SYN_BATCH;
+    long last = now_us();
+    int exhausted = 0;
+    for (;;) {
+        expire(&s, &routes);
+
+        long now = now_us();
+        tokens += (now - last) * rate / 1e6;
+        if (tokens > SYN_BATCH) tokens = SYN_BATCH;
+        last = now;
+
+        int sent = 0;
+        while (!exhausted && tokens >= 1) {
+            pthread_mutex_lock(&s.lock);
+            int have_slot = s.free_count > 0;
+            pthread_mutex_unlock(&s.lock);
+            if (!have_slot) break;
+
+            struct in_addr addr;
+            int port;
+            if (!next(src, &addr, &port)) {
+                exhausted = 1;
+                break;
+            }
+            stats->sent++;
+            uint32_t from = route_lookup(&routes, addr.s_addr);
+            if (!from) {
+                pthread_mutex_lock(&s.lock);
+                stats->filtered++;
+                pthread_mutex_unlock(&s.lock);
+                report(&s, addr.s_addr, port, PORT_FILTERED);
+                continue;
+            }
+
+            // Registrar antes de enviar: la respuesta puede llegar enseguida
+            pthread_mutex_lock(&s.lock);
+            int slot = s.free_list[--s.free_count];
+            syn_probe_t *p = &s.probes[slot];
+            p->addr = addr.s_addr;
+            p->port = port;
+            p->tries = 1;
+            p->deadline_us = now_us() + s.timeout_us;
+            index_put(&s.index, probe_key(p->addr, p->port), slot);
+            s.heap[s.heap_len] = slot;
+            p->heap_pos = s.heap_len++;
+            heap_up(&s, s.heap_len - 1);
+            pthread_mutex_unlock(&s.lock);
+
+            // Un fallo al enviar se queda en vuelo y lo resuelve el reintento
+            send_syn(&s, from, addr.s_addr, port);
+            tokens--;
+            sent++;
+        }
+
+        pthread_mutex_lock(&s.lock);
+        int pending = s.heap_len;
+        pthread_mutex_unlock(&s.lock);
+        if (exhausted && pending == 0) break;
+        if (!sent) {
+            struct timespec pause = {0, 200000};
+            nanosleep(&pause, NULL);
+        }
+    }
+
+    __atomic_store_n(&s.stop, 1, __ATOMIC_RELEASE);
+    pthread_join(th, NULL);
+    pthread_mutex_destroy(&s.lock);
+    rc = 0;
+
+out:
+    if (rc != 0) perror("syn_run");
+    if (reserved >= 0) close(reserved);
+    close(raw);
+    free(s.probes);
+    free(s.free_list);
+    free(s.heap);
+    free(s.index.keys);
+    free(s.index.slots);
+    free(routes.dst);
+    free(routes.src);
+    return rc;
+}
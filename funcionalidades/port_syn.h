@@ -0,0 +1,22 @@
+#ifndef PORT_SYN_H
+#define PORT_SYN_H
+
+#include "port_engine.h"
+
+#define SYN_DEFAULT_RATE 50000   // SYN por segundo si cfg->rate_pps es 0
+#define SYN_DEFAULT_INFLIGHT 65536 // Sondas en vuelo por defecto: no gastan descriptores
+#define SYN_NO_PRIVILEGE (-2)    // syn_run sin CAP_NET_RAW: usar engine_run_pool
+
+// Escaneo semiabierto: un socket raw envía los SYN en ráfagas acompasadas y
+// un hilo receptor empareja las respuestas SYN-ACK (abierto) y RST (cerrado).
+// Nunca se completa el handshake: el kernel responde RST al SYN-ACK porque
+// ningún socket nuestro espera esa conexión. Las sondas sin respuesta se
+// reintentan una vez y después se dan por filtradas.
+//
+// Usa max_inflight, timeout_ms y rate_pps de cfg; no lee banners. El
+// callback se invoca desde el hilo emisor y desde el receptor. Devuelve 0,
+// -1 si falla o SYN_NO_PRIVILEGE si no se puede abrir el socket raw.
+int syn_run(const engine_config_t *cfg, engine_next_fn next, void *src,
+            engine_result_fn on_result, void *ctx, engine_stats_t *stats);
+
+#endif
@@ -0,0 +1,177 @@
+#define _GNU_SOURCE
+#include "port_targets.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+
+static int add_host(target_list_t *t, struct in_addr addr) {
+    if (t->count >= MAX_TARGET_HOSTS) {
+        fprintf(stderr, "Demasiados objetivos (máximo %d hosts).\n", MAX_TARGET_HOSTS);
+        return -1;
+    }
+    if (t->count == t->cap) {
+        size_t cap = t->cap ? t->cap * 2 : 16;
+        struct in_addr *h = realloc(t->hosts, cap * sizeof(*h));
+        if (!h) return -1;
+        t->hosts = h;
+        t->cap = cap;
+    }
+    t->hosts[t->count++] = addr;
+    return 0;
+}
+
+// Recorta espacios en blanco al inicio y al final (in situ)
+static char *trim(char *s) {
+    while (isspace((unsigned char)*s)) s++;
+    char *e = s + strlen(s);
+    while (e > s && isspace((unsigned char)e[-1])) *--e = '\0';
+    return s;
+}
+
+static int add_cidr(target_list_t *t, const char *ip, const char *bits_str) {
+    char *end;
+    long bits = strtol(bits_str, &end, 10);
+    struct in_addr base;
+    if (*end || bits < 0 || bits > 32 || inet_pton(AF_INET, ip, &base) != 1) {
+        fprintf(stderr, "Rango CIDR inválido: %s/%s\n", ip, bits_str);
+        return -1;
+    }
+    if (bits < 16) {
+        fprintf(stderr, "Rango %s/%ld demasiado grande (mínimo /16).\n", ip, bits);
+        return -1;
+    }
+
+    uint32_t mask = bits == 0 ? 0 : 0xFFFFFFFFu << (32 - bits);
+    uint32_t first = ntohl(base.s_addr) & mask;
+    uint32_t last = first | ~mask;
+    // En redes de más de dos direcciones se omiten la de red y la de broadcast
+    if (bits < 31) {
+        first++;
+        last--;
+    }
+    for (uint32_t h = first; ; h++) {
+        struct in_addr a = {.s_addr = htonl(h)};
+        if (add_host(t, a) != 0) return -1;
+        if (h == last) break;
+    }
+    return 0;
+}
+
+static int add_name(target_list_t *t, const char *name) {
+    struct in_addr a;
+    if (inet_pton(AF_INET, name, &a) == 1) return add_host(t, a);
+
+    struct addrinfo hints = {.ai_family = AF_INET, .ai_socktype = SOCK_STREAM};
+    struct addrinfo *res;
+    int rc = getaddrinfo(name, NULL, &hints, &res);
+    if (rc != 0) {
+        fprintf(stderr, "No se pudo resolver %s: %s\n", name, gai_strerror(rc));
+        return -1;
+    }
+    a = ((struct sockaddr_in *)res->ai_addr)->sin_addr;
+    freeaddrinfo(res);
+    return add_host(t, a);
+}
+
+int targets_parse(const char *spec, target_list_t *out) {
+    memset(out, 0, sizeof(*out));
+    char *copy = strdup(spec), *save = NULL;
+    if (!copy) return -1;
+
+    int rc = 0;
+    for (char *tok = strtok_r(copy, ", ", &save); tok && rc == 0; tok = strtok_r(NULL, ", ", &save)) {
+        tok = trim(tok);
+        if (!*tok) continue;
+        char *slash = strchr(tok, '/');
+        if (slash) {
+            *slash = '\0';
+            rc = add_cidr(out, tok, slash + 1);
+        } else {
+            rc = add_name(out, tok);
+        }
+    }
+    free(copy);
+
+    if (rc == 0 && out->count == 0) {
+        fprintf(stderr, "No se indicó ningún objetivo.\n");
+        rc = -1;
+    }
+    if (rc != 0) targets_free(out);
+    return rc;
+}
+
+void targets_free(target_list_t *t) {
+    free(t->hosts);
+    memset(t, 0, sizeof(*t));
+}
+
+int ports_parse(const char *spec, port_set_t *out) {
+    memset(out, 0, sizeof(*out));
+    unsigned char *seen = calloc(65536 / 8, 1);
+    char *copy = strdup(spec), *save = NULL;
+    if (!seen || !copy) {
+        free(seen);
+        free(copy);
+        return -1;
+    }
+
+    int rc = 0;
+    for (char *tok = strtok_r(copy, ", ", &save); tok; tok = strtok_r(NULL, ", ", &save)) {
+        tok = trim(tok);
+        if (!*tok) continue;
+        long lo, hi;
+        char *end;
+        lo = strtol(tok, &end, 10);
+        if (*end == '-') hi = strtol(end + 1, &end, 10);
+        else hi = lo;
+        if (*end || lo < 1 || hi > 65535 || lo > hi) {
+            fprintf(stderr, "Puertos inválidos: %s (deben estar entre 1 y 65535).\n", tok);
+            rc = -1;
+            break;
+        }
+        for (long p = lo; p <= hi; p++) seen[p >> 3] |= 1 << (p & 7);
+    }
+    free(copy);
+
+    if (rc == 0) {
+        size_t n = 0;
+        for (int p = 1; p < 65536; p++)
+            if (seen[p >> 3] & (1 << (p & 7))) n++;
+        out->ports = malloc((n ? n : 1) * sizeof(uint16_t));
+        if (!out->ports) rc = -1;
+        for (int p = 1; rc == 0 && p < 65536; p++)
+            if (seen[p >> 3] & (1 << (p & 7))) out->ports[out->count++] = p;
+        if (rc == 0 && out->count == 0) {
+            fprintf(stderr, "No se indicó ningún puerto.\n");
+            rc = -1;
+        }
+    }
+    free(seen);
+    if (rc != 0) ports_free(out);
+    return rc;
+}
+
+void ports_free(port_set_t *p) {
+    free(p->ports);
+    memset(p, 0, sizeof(*p));
+}
+
+void plan_init(scan_plan_t *plan, const target_list_t *targets, const port_set_t *ports) {
+    plan->targets = targets;
+    plan->ports = ports;
+    plan->total = (unsigned long)targets->count * ports->count;
+    plan->next_index = 0;
+}
+
+int plan_next(void *src, struct in_addr *addr, int *port) {
+    scan_plan_t *plan = src;
+    unsigned long i = __atomic_fetch_add(&plan->next_index, 1, __ATOMIC_RELAXED);
+    if (i >= plan->total) return 0;
+    size_t n = plan->targets->count;
+    *addr = plan->targets->hosts[i % n];
+    *port = plan->ports->ports[i / n];
+    return 1;
+}
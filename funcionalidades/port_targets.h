@@ -0,0 +1,44 @@
+#ifndef PORT_TARGETS_H
+#define PORT_TARGETS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <netinet/in.h>
+
+#define MAX_TARGET_HOSTS 65536   // Tope de hosts tras expandir rangos CIDR (/16)
+
+typedef struct {
+    struct in_addr *hosts;
+    size_t count;
+    size_t cap;
+} target_list_t;
+
+typedef struct {
+    uint16_t *ports;             // Ordenados y sin repetidos
+    size_t count;
+} port_set_t;
+
+// Plan de escaneo: recorre los pares (host, puerto) intercalando hosts,
+// es decir, el índice i corresponde a hosts[i % n] y ports[i / n].
+// next_index se reparte atómicamente entre los hilos de trabajo.
+typedef struct {
+    const target_list_t *targets;
+    const port_set_t *ports;
+    unsigned long total;
+    unsigned long next_index;
+} scan_plan_t;
+
+// "10.0.0.1, servidor.local, 192.168.1.0/24". Devuelve 0 o -1 con mensaje en stderr.
+int targets_parse(const char *spec, target_list_t *out);
+void targets_free(target_list_t *t);
+
+// "22,80,1000-2000". Devuelve 0 o -1 con mensaje en stderr.
+int ports_parse(const char *spec, port_set_t *out);
+void ports_free(port_set_t *p);
+
+void plan_init(scan_plan_t *plan, const target_list_t *targets, const port_set_t *ports);
+
+// Compatible con engine_next_fn y seguro entre hilos
+int plan_next(void *plan, struct in_addr *addr, int *port);
+
+#endif
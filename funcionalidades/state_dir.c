@@ -0,0 +1,25 @@
+#include "state_dir.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+int state_path(char *out, size_t len, const char *name) {
+    char dir[512];
+    const char *env = getenv("MATCOM_GUARD_STATE");
+    const char *home = getenv("HOME");
+
+    if (env && *env) snprintf(dir, sizeof(dir), "%s", env);
+    else if (geteuid() == 0) snprintf(dir, sizeof(dir), "/var/lib/matcom_guard");
+    else if (home && *home) snprintf(dir, sizeof(dir), "%s/.matcom_guard", home);
+    else return -1;
+
+    if (mkdir(dir, 0700) != 0 && errno != EEXIST) {
+        perror(dir);
+        return -1;
+    }
+    if ((size_t)snprintf(out, len, "%s/%s", dir, name) >= len) return -1;
+    return 0;
+}
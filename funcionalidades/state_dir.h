@@ -0,0 +1,12 @@
+#ifndef STATE_DIR_H
+#define STATE_DIR_H
+
+#include <stddef.h>
+
+// Directorio de estado persistente de MatCom Guard: $MATCOM_GUARD_STATE si
+// está definida, /var/lib/matcom_guard para root y ~/.matcom_guard en otro
+// caso. Escribe en out la ruta de name dentro de él, creando el directorio
+// si hace falta. Devuelve 0 o -1.
+int state_path(char *out, size_t len, const char *name);
+
+#endif